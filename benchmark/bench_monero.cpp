@@ -1,6 +1,17 @@
 #include <benchmark/benchmark.h>
 
+#include <cstring>
+#include <string>
+#include <vector>
 #include <fingera/hash/monero.hpp>
+#include <fingera/dispatch.hpp>
+#include <fingera/hugepages.hpp>
+extern "C" {
+#include "hash/monero/oaes_lib.h"
+#include "hash/monero/hash-ops.h"
+#include "hash/monero/keccak.h"
+void aesb_expand_key(const uint8_t *key, uint8_t *expandedKey);
+}
 
 static uint8_t block_unknow[76] = {
     0x07
@@ -22,4 +33,226 @@ static void TEST_CPU_FAST(benchmark::State& state) {
 }
 BENCHMARK(TEST_CPU_FAST);
 
+// key setup of the software AES paths, twice per hash: oaes_alloc, import
+// and free as cn_slow_hash did, against the stack-only aesb_expand_key
+static void TEST_AES_KEY_SETUP_OAES(benchmark::State& state) {
+    uint8_t key[32] = {1};
+    uint8_t expanded[240];
+    for (auto _ : state) {
+        OAES_CTX *ctx = oaes_alloc();
+        oaes_key_import_data(ctx, key, sizeof(key));
+        memcpy(expanded, ((oaes_ctx *)ctx)->key->exp_data, sizeof(expanded));
+        oaes_free(&ctx);
+        benchmark::DoNotOptimize(expanded);
+    }
+}
+BENCHMARK(TEST_AES_KEY_SETUP_OAES);
+
+static void TEST_AES_KEY_SETUP_AESB(benchmark::State& state) {
+    uint8_t key[32] = {1};
+    uint8_t expanded[240];
+    for (auto _ : state) {
+        aesb_expand_key(key, expanded);
+        benchmark::DoNotOptimize(expanded);
+    }
+}
+BENCHMARK(TEST_AES_KEY_SETUP_AESB);
+
+static const char *kind_names[] = {"none", "hugetlb", "transparent", "normal"};
+
+static void TEST_CPU_FAST_DISPATCH(benchmark::State& state, const fingera::dispatch::monero_backend *backend) {
+    fingera::hugepage_buffer scratchpad(fingera::hash::monero_scratchpad_size);
+    char out[32];
+    for (auto _ : state) {
+        backend->cpu_fast(block_unknow, sizeof(block_unknow), out, scratchpad.data());
+    }
+    state.SetLabel(kind_names[scratchpad.kind()]);
+}
+
+// N hashes per call, items = hashes
+static void TEST_CPU_FAST_MULTI(benchmark::State& state, const fingera::dispatch::monero_backend *backend, int n) {
+    uint8_t blocks[5][sizeof(block_unknow)];
+    const void *blobs[5];
+    size_t lengths[5];
+    char out[5][32];
+    void *results[5];
+    for (int i = 0; i < n; i++) {
+        memcpy(blocks[i], block_unknow, sizeof(block_unknow));
+        blocks[i][39] = (uint8_t)i;
+        blobs[i] = blocks[i];
+        lengths[i] = sizeof(block_unknow);
+        results[i] = out[i];
+    }
+    fingera::hugepage_buffer scratchpad(fingera::hash::monero_scratchpad_size * n);
+    for (auto _ : state) {
+        backend->cpu_fast_multi[n - 1](blobs, lengths, results, scratchpad.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    state.SetLabel(kind_names[scratchpad.kind()]);
+}
+static void TEST_CRYPTONIGHT(benchmark::State& state, const fingera::dispatch::cryptonight_kernel *kernel) {
+    fingera::hugepage_buffer scratchpad(kernel->memory);
+    char out[32];
+    for (auto _ : state) {
+        kernel->hash(block_unknow, sizeof(block_unknow), out, scratchpad.data());
+    }
+    state.SetLabel(kind_names[scratchpad.kind()]);
+}
+static void TEST_CN_R(benchmark::State& state, const fingera::dispatch::monero_backend *backend, bool jit) {
+    fingera::hugepage_buffer scratchpad(fingera::hash::monero_scratchpad_size);
+    fingera::hash::cryptonight_r_program program(1806260, jit);
+    char out[32];
+    for (auto _ : state) {
+        backend->cn_r(block_unknow, sizeof(block_unknow), out, scratchpad.data(), program);
+    }
+    state.SetLabel(kind_names[scratchpad.kind()]);
+}
+
+// a job's nonces in the fastest backend, the target lets no share through
+static void TEST_CRYPTONIGHT_SCAN(benchmark::State& state) {
+    const int ways = (int)state.range(0);
+    uint32_t nonce = 0;
+    for (auto _ : state) {
+        fingera::hash::cryptonight_scan("cn/1", block_unknow, sizeof(block_unknow), nonce, nonce + 20, 0,
+            [](uint32_t, const void *) {}, ways);
+        nonce += 20;
+    }
+    state.SetItemsProcessed(state.iterations() * 20);
+}
+BENCHMARK(TEST_CRYPTONIGHT_SCAN)->DenseRange(1, 5);
+
+// one finalizer on the 200 bytes keccak state
+static void TEST_MONERO_EXTRA(benchmark::State& state, fingera::dispatch::monero_extra_hash extra) {
+    uint8_t data[200];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t)i;
+    char out[32];
+    for (auto _ : state) {
+        extra(data, sizeof(data), out);
+        data[0] ^= out[0];
+    }
+}
+
+// keccak.c keccakf against the dispatch backends, items = states permuted
+static void TEST_KECCAKF(benchmark::State& state) {
+    uint64_t st[25] = {1};
+    for (auto _ : state) {
+        keccakf(st, 24);
+    }
+    benchmark::DoNotOptimize(st);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(TEST_KECCAKF);
+
+static void TEST_KECCAKF_DISPATCH(benchmark::State& state, const fingera::dispatch::keccak_backend *backend) {
+    uint64_t st[8][25] = {};
+    uint64_t *lanes[8];
+    for (int i = 0; i < backend->way; i++) {
+        st[i][0] = i;
+        lanes[i] = st[i];
+    }
+    for (auto _ : state) {
+        backend->keccakf(lanes);
+    }
+    benchmark::DoNotOptimize(st);
+    state.SetItemsProcessed(state.iterations() * backend->way);
+}
+
+// transaction ids: 256 messages of 200 .. 2000 bytes, hash.c one by one
+// against the batch, items = messages
+static std::vector<std::vector<uint8_t>> transactions() {
+    std::vector<std::vector<uint8_t>> txs;
+    for (int i = 0; i < 256; i++) txs.emplace_back(200 + (i * 523) % 1800, (uint8_t)i);
+    return txs;
+}
+
+static void TEST_CN_FAST_HASH(benchmark::State& state) {
+    const std::vector<std::vector<uint8_t>> txs = transactions();
+    char out[32];
+    for (auto _ : state) {
+        for (auto &tx : txs) cn_fast_hash(&tx[0], tx.size(), out);
+    }
+    state.SetItemsProcessed(state.iterations() * txs.size());
+}
+BENCHMARK(TEST_CN_FAST_HASH);
+
+static void TEST_CN_FAST_HASH_MANY(benchmark::State& state) {
+    const std::vector<std::vector<uint8_t>> txs = transactions();
+    std::vector<const void *> messages;
+    std::vector<size_t> lengths;
+    for (auto &tx : txs) {
+        messages.push_back(&tx[0]);
+        lengths.push_back(tx.size());
+    }
+    std::vector<uint8_t> out(txs.size() * 32);
+    for (auto _ : state) {
+        fingera::hash::cn_fast_hash_many(&messages[0], &lengths[0], txs.size(), &out[0]);
+    }
+    state.SetItemsProcessed(state.iterations() * txs.size());
+}
+BENCHMARK(TEST_CN_FAST_HASH_MANY);
+
+// a 2000 transactions block: the branch once per template, then a root per
+// coinbase change
+static void TEST_TREE_HASH_BRANCH(benchmark::State& state) {
+    std::vector<uint8_t> hashes(2000 * 32, 7);
+    for (auto _ : state) {
+        fingera::hash::tree_hash_branch branch(&hashes[0], 2000, (unsigned)state.range(0));
+        benchmark::DoNotOptimize(branch.branch());
+    }
+}
+BENCHMARK(TEST_TREE_HASH_BRANCH)->Arg(1)->Arg(4);
+
+static void TEST_TREE_HASH_ROOT(benchmark::State& state) {
+    std::vector<uint8_t> hashes(2000 * 32, 7);
+    const fingera::hash::tree_hash_branch branch(&hashes[0], 2000);
+    uint8_t root[32] = {};
+    for (auto _ : state) {
+        branch.root(root, root);
+    }
+}
+BENCHMARK(TEST_TREE_HASH_ROOT);
+
+// once per job
+static void TEST_CN_R_PROGRAM(benchmark::State& state, bool jit) {
+    uint64_t height = 1806260;
+    for (auto _ : state) {
+        fingera::hash::cryptonight_r_program program(height++, jit);
+        benchmark::DoNotOptimize(program.native());
+    }
+}
+BENCHMARK_CAPTURE(TEST_CN_R_PROGRAM, jit, true);
+BENCHMARK_CAPTURE(TEST_CN_R_PROGRAM, interpreted, false);
+
+static int register_dispatch = [] {
+    for (auto backend : fingera::dispatch::monero_backends()) {
+        benchmark::RegisterBenchmark((std::string("TEST_CPU_FAST<") + backend->name + ">").c_str(),
+            TEST_CPU_FAST_DISPATCH, backend);
+        for (int n = 1; n <= 5; n++) {
+            benchmark::RegisterBenchmark((std::string("TEST_CPU_FAST_MULTI<") + backend->name + "," + std::to_string(n) + ">").c_str(),
+                TEST_CPU_FAST_MULTI, backend, n);
+        }
+        for (size_t i = 0; i < backend->kernel_count; i++) {
+            benchmark::RegisterBenchmark((std::string("TEST_CRYPTONIGHT<") + backend->name + "," + backend->kernels[i].algorithm + ">").c_str(),
+                TEST_CRYPTONIGHT, &backend->kernels[i]);
+        }
+        benchmark::RegisterBenchmark((std::string("TEST_CN_R<") + backend->name + ",jit>").c_str(),
+            TEST_CN_R, backend, true);
+        benchmark::RegisterBenchmark((std::string("TEST_CN_R<") + backend->name + ",interpreted>").c_str(),
+            TEST_CN_R, backend, false);
+    }
+    static const char *const extra_names[4] = {"blake256", "groestl256", "jh256", "skein256"};
+    for (auto backend : fingera::dispatch::monero_extra_backends()) {
+        for (int i = 0; i < 4; i++) {
+            if (!backend->extra[i]) continue;
+            benchmark::RegisterBenchmark((std::string("TEST_MONERO_EXTRA<") + backend->name + "," + extra_names[i] + ">").c_str(),
+                TEST_MONERO_EXTRA, backend->extra[i]);
+        }
+    }
+    for (auto backend : fingera::dispatch::keccak_backends()) {
+        benchmark::RegisterBenchmark((std::string("TEST_KECCAKF<") + backend->name + ">").c_str(),
+            TEST_KECCAKF_DISPATCH, backend);
+    }
+    return 0;
+}();
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -1,9 +1,15 @@
 #include <benchmark/benchmark.h>
 #include <fingera/config.hpp>
+#include <fingera/dispatch.hpp>
+#include <cstring>
+#include <vector>
 #include <fingera/hash/multiway_sha256.hpp>
+#include <fingera/hash/sha256d.hpp>
 #include <fingera/multiway_integer.hpp>
 #include <fingera/instrinsic/mi_sse2.hpp>
 #include <fingera/instrinsic/mi_avx2.hpp>
+#include <fingera/instrinsic/mi_avx512.hpp>
+#include <fingera/hash/sha256_shani.hpp>
 #include <fingera/instrinsic/mi_mmx.hpp>
 
 
@@ -53,6 +59,7 @@ static void SHA256_1000(benchmark::State& state) {
     for (auto _ : state) {
         for (int i = 0; i < 1000; i++) {
             T::process_trunk(result, blocks);
+            benchmark::DoNotOptimize(result);
         }
     }
 }
@@ -83,6 +90,136 @@ BENCHMARK_TEMPLATE(SHA256_1000, sse2_4_way);
 using avx2_8_way = hash::multiway_sha256<instrinsic::mi_avx2>;
 BENCHMARK_TEMPLATE(SHA256_1000, avx2_8_way);
 #endif
+#if defined(FINGERA_USE_AVX512F)
+using avx512_16_way = hash::multiway_sha256<instrinsic::mi_avx512>;
+BENCHMARK_TEMPLATE(SHA256_1000, avx512_16_way);
+#endif
+#if defined(FINGERA_USE_SHA)
+using shani_1_way = hash::sha256_shani;
+BENCHMARK_TEMPLATE(SHA256_1000, shani_1_way);
+#endif
+
+static void SHA256_1000_DISPATCH(benchmark::State& state, const dispatch::sha256_backend *backend) {
+    uint8_t blocks[64 * 16];
+    uint8_t result[32 * 16];
+    for (auto _ : state) {
+        for (int i = 0; i < 1000; i++) {
+            backend->process_trunk(result, blocks, 1);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+}
+// the same blocks laid out lane-major by the caller, no transpose at all
+static void SHA256_1000_LANES_DISPATCH(benchmark::State& state, const dispatch::sha256_backend *backend) {
+    uint8_t blocks[64 * 16];
+    uint8_t result[32 * 16];
+    for (auto _ : state) {
+        for (int i = 0; i < 1000; i++) {
+            backend->process_trunk_lanes(result, blocks, 1);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+}
+// 1000 messages of 1 .. 1024 bytes, lanes refilled as messages end, items = messages
+static void SHA256_MANY_DISPATCH(benchmark::State& state, const dispatch::sha256_backend *backend) {
+    std::vector<uint8_t> data(1024, 0x5a);
+    std::vector<const void *> messages(1000, &data[0]);
+    std::vector<size_t> lengths(1000);
+    size_t bytes = 0;
+    for (size_t i = 0; i < lengths.size(); i++) {
+        lengths[i] = 1 + (i * 7919) % 1024;
+        bytes += lengths[i];
+    }
+    std::vector<uint8_t> result(32 * 1000);
+    for (auto _ : state) {
+        backend->process_many(&messages[0], &lengths[0], messages.size(), &result[0]);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * 1000);
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+// sha256d over 80 bytes headers, items = nonces
+static void SHA256D_SCAN_DISPATCH(benchmark::State& state, const dispatch::sha256_backend *backend) {
+    uint8_t header[80] = {0};
+    uint8_t target[32] = {0};
+    uint32_t found[16];
+    uint32_t nonce = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(backend->scan_nonces(header, nonce, 16000, target, found, 16));
+        nonce += 16000;
+    }
+    state.SetItemsProcessed(state.iterations() * 16000);
+}
+// the same work through process_trunk: padded blocks in memory, both header blocks hashed
+static void SHA256D_NAIVE_DISPATCH(benchmark::State& state, const dispatch::sha256_backend *backend) {
+    const int way = backend->way;
+    std::vector<uint8_t> blocks(way * 128, 0);
+    std::vector<uint8_t> inner(way * 64, 0);
+    std::vector<uint8_t> digest(way * 32);
+    std::vector<uint8_t> result(way * 32);
+    for (int i = 0; i < way; i++) {
+        blocks[way * 64 + i * 64 + 16] = 0x80;
+        blocks[way * 64 + i * 64 + 62] = 0x02;
+        blocks[way * 64 + i * 64 + 63] = 0x80;
+        inner[i * 64 + 32] = 0x80;
+        inner[i * 64 + 62] = 0x01;
+    }
+    uint32_t nonce = 0;
+    for (auto _ : state) {
+        for (int n = 0; n < 16000; n += way) {
+            for (int i = 0; i < way; i++) {
+                write_little<uint32_t>(&blocks[way * 64 + i * 64 + 12], nonce++);
+            }
+            backend->process_trunk(&digest[0], &blocks[0], 2);
+            for (int i = 0; i < way; i++) {
+                memcpy(&inner[i * 64], &digest[i * 32], 32);
+            }
+            backend->process_trunk(&result[0], &inner[0], 1);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 16000);
+}
+// Merkle root of range(0) leaves on range(1) threads
+static void MERKLE_ROOT(benchmark::State& state) {
+    std::vector<uint8_t> leaves(32 * state.range(0));
+    for (size_t i = 0; i < leaves.size(); i++) {
+        leaves[i] = (uint8_t)(i * 131);
+    }
+    uint8_t root[32];
+    for (auto _ : state) {
+        hash::merkle_root(leaves, root, (unsigned)state.range(1));
+        benchmark::DoNotOptimize(root);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(MERKLE_ROOT)->Args({4096, 1})->Args({1 << 20, 1})->Args({1 << 20, 4})->UseRealTime();
+
+static int register_dispatch = [] {
+    for (auto backend : dispatch::sha256_backends()) {
+        benchmark::RegisterBenchmark((std::string("SHA256_1000<dispatch_") + backend->name + ">").c_str(),
+            SHA256_1000_DISPATCH, backend);
+    }
+    for (auto backend : dispatch::sha256_backends()) {
+        benchmark::RegisterBenchmark((std::string("SHA256_1000_LANES<dispatch_") + backend->name + ">").c_str(),
+            SHA256_1000_LANES_DISPATCH, backend);
+    }
+    for (auto backend : dispatch::sha256_backends()) {
+        benchmark::RegisterBenchmark((std::string("SHA256D_SCAN<dispatch_") + backend->name + ">").c_str(),
+            SHA256D_SCAN_DISPATCH, backend);
+        benchmark::RegisterBenchmark((std::string("SHA256D_NAIVE<dispatch_") + backend->name + ">").c_str(),
+            SHA256D_NAIVE_DISPATCH, backend);
+    }
+    for (auto backend : dispatch::sha256_backends()) {
+        benchmark::RegisterBenchmark((std::string("SHA256_MANY<dispatch_") + backend->name + ">").c_str(),
+            SHA256_MANY_DISPATCH, backend);
+    }
+    for (auto backend : dispatch::sha256_single_backends()) {
+        benchmark::RegisterBenchmark((std::string("SHA256_1000<dispatch_single_") + backend->name + ">").c_str(),
+            SHA256_1000_DISPATCH, backend);
+    }
+    return 0;
+}();
 
 
 void inline Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
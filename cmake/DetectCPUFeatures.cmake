@@ -25,6 +25,9 @@ if (${COMPILE_RESULT} STREQUAL "TRUE")
             elseif (${feature} STREQUAL "aes")
                 message("Enable aes")
                 set(FINGERA_USE_AES ON PARENT_SCOPE)
+            elseif (${feature} STREQUAL "sha")
+                message("Enable sha")
+                set(FINGERA_USE_SHA ON PARENT_SCOPE)
             endif()
         endforeach()
     else()
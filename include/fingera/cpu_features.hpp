@@ -1,9 +1,88 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace fingera {
 
 bool get_cpu_features(std::unordered_map<std::string, bool> &features);
 
-} // namespace fingera
\ No newline at end of file
+// The CPUID words get_cpu_features reads, zero for leaves above the maximum
+struct cpuid_leaves {
+    unsigned max_level;         // leaf 0 eax
+    unsigned leaf1_cx;
+    unsigned leaf1_dx;
+    unsigned xcr0;              // XGETBV(0) eax, zero without OSXSAVE
+    unsigned max_ext_level;     // leaf 0x80000000 eax
+    unsigned ext1_cx;           // leaf 0x80000001 ecx
+    unsigned leaf7_bx;          // leaf 7 subleaf 0
+    unsigned leaf7_cx;
+    unsigned leafd1_ax;         // leaf 0xd subleaf 1
+};
+
+// get_cpu_features from given leaves, false when max_level < 1
+bool decode_cpu_features(const cpuid_leaves &leaves, std::unordered_map<std::string, bool> &features);
+
+// One cache instance and the logical cpus sharing it
+struct cpu_cache {
+    enum type_t {
+        data = 1,
+        instruction = 2,
+        unified = 3,
+    };
+
+    int level;
+    type_t type;
+    size_t size;            // bytes
+    size_t line_size;
+    std::vector<int> cpus;  // ascending
+};
+
+// One physical core and its SMT siblings
+struct cpu_core {
+    enum type_t {
+        unknown,            // not a hybrid cpu
+        performance,
+        efficiency,
+    };
+
+    type_t type;
+    int package;
+    std::vector<int> cpus;  // ascending
+};
+
+// One NUMA node with allowed cpus
+struct cpu_node {
+    int id;
+    std::vector<int> cpus;  // ascending
+};
+
+// Only the logical cpus this process may run on appear in it
+struct cpu_topology {
+    std::vector<int> cpus;          // ascending
+    std::vector<cpu_core> cores;    // by first cpu
+    std::vector<cpu_cache> caches;  // by level, type, first cpu
+    std::vector<cpu_node> nodes;    // by id, empty when unknown
+    bool hybrid = false;
+    // /sys/devices/system/cpu grouped the cpus differently than CPUID, its
+    // grouping is the one used
+    bool sysfs_mismatch = false;
+
+    // -1 when unknown
+    int node_of(int cpu) const;
+    // highest cache level, 0 without caches
+    int last_level() const;
+    // bytes of one data or unified cache of level, 0 without one
+    size_t cache_size(int level) const;
+    // bytes of every data or unified cache of level
+    size_t total_cache_size(int level) const;
+};
+
+// CPUID leaves 4 (0x8000001D on AMD) and 0xB / 0x1F run on every cpu,
+// cross-checked with /sys/devices/system/cpu on linux. NUMA nodes from
+// /sys/devices/system/node. False when neither CPUID nor sysfs works.
+bool get_cpu_topology(cpu_topology &topology);
+
+} // namespace fingera
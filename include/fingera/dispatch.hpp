@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace fingera {
+namespace hash {
+class cryptonight_r_program;
+} // namespace hash
+
+namespace dispatch {
+
+// multiway_sha256<Instr> or sha256_shani, compiled in its own translation
+// unit with its target flags (src/hash/multiway_sha256_*.cpp, sha256_shani.cpp)
+struct sha256_backend {
+    const char *name;       // "avx512f", "avx2", "sse2", "sha", "generic"
+    // get_cpu_features keys required, space separated ("sha sse4.1"),
+    // nullptr = always
+    const char *feature;
+    int way;                // messages per process_trunk
+    void (*process_trunk)(void *out, const void *blocks, int count);
+    // multiway_sha256::process_trunk_lanes (lane-major blocks and state),
+    // nullptr for single buffer engines
+    void (*process_trunk_lanes)(void *out, const void *blocks, int count);
+    // multiway_sha256::process_many (any lengths, lanes refilled), nullptr for
+    // single buffer engines
+    void (*process_many)(const void *const *messages, const size_t *lengths, size_t count, void *out);
+    // multiway_sha256::sha256d_64 (Merkle nodes), nullptr for single buffer engines
+    void (*sha256d_64)(void *out, const void *in, size_t count);
+    // multiway_sha256::scan_nonces, nullptr for single buffer engines
+    size_t (*scan_nonces)(const void *header80, uint32_t nonce_start, uint64_t count,
+        const void *target, uint32_t *found, size_t max_found);
+};
+
+// One CryptoNight family member, memory and iterations compiled in
+// (src/hash/cryptonight.hpp)
+struct cryptonight_kernel {
+    const char *algorithm;  // "cn/0", "cn/1", "cn/msr", "cn/2", "cn/half", "cn-lite/0", "cn-lite/1"
+    size_t memory;          // scratchpad bytes per hash
+    // scratchpad: memory bytes per hash, 16 aligned
+    void (*hash)(const void *blob, size_t length, void *result, void *scratchpad);
+    // [N - 1]: N hashes at once, interleaved where the backend can
+    void (*hash_multi[5])(const void *const *blobs, const size_t *lengths, void *const *results,
+        void *scratchpad);
+};
+
+// monero_cpu_fast implementation (src/hash/monero_*.cpp)
+struct monero_backend {
+    const char *name;       // "vaes", "aesni", "softaes", "portable"
+    const char *feature;
+    // "cn/1": scratchpad is hash::monero_scratchpad_size bytes per hash
+    void (*cpu_fast)(const void *block_blob, size_t length, void *result, void *scratchpad);
+    void (*cpu_fast_multi[5])(const void *const *block_blobs, const size_t *lengths, void *const *results,
+        void *scratchpad);
+    // every family member, cpu_fast included
+    const cryptonight_kernel *kernels;
+    size_t kernel_count;
+    // "cn/r", one hash: scratchpad is hash::monero_scratchpad_size bytes
+    void (*cn_r)(const void *blob, size_t length, void *result, void *scratchpad,
+        const hash::cryptonight_r_program &program);
+};
+
+// CryptoNight finalizers, extra[h[0] & 3] hashes the 200 bytes keccak
+// state: blake256, groestl256, jh256, skein256 (src/hash/monero_extra_*.cpp)
+using monero_extra_hash = void (*)(const void *data, size_t length, char *hash);
+struct monero_extra_backend {
+    const char *name;       // "aesni", "sse4.1", "sse2", "portable"
+    const char *feature;
+    monero_extra_hash extra[4];     // nullptr: not in this backend
+};
+
+// Keccak-f[1600] on several states at once (src/hash/keccak*.cpp)
+struct keccak_backend {
+    const char *name;       // "avx512f", "avx2", "portable"
+    const char *feature;
+    int way;                // states per keccakf
+    // keccak.c keccakf(st, 24) on states[0 .. way - 1], 25 lanes each
+    void (*keccakf)(uint64_t *const *states);
+};
+
+// The fastest backend the running cpu supports, selected on first use.
+const sha256_backend &sha256();
+const monero_backend &monero();
+// Every finalizer from the fastest backend implementing it
+const monero_extra_hash *monero_extra();
+const keccak_backend &keccak();
+// The kernel of the fastest backend implementing algorithm, nullptr if none
+const cryptonight_kernel *cryptonight(const char *algorithm);
+// Lowest latency for a single message (way == 1): "sha" or "generic"
+const sha256_backend &sha256_single();
+
+// Every backend the running cpu supports, fastest first.
+const std::vector<const sha256_backend *> &sha256_backends();
+const std::vector<const sha256_backend *> &sha256_single_backends();
+const std::vector<const monero_backend *> &monero_backends();
+const std::vector<const monero_extra_backend *> &monero_extra_backends();
+const std::vector<const keccak_backend *> &keccak_backends();
+
+} // namespace dispatch
+} // namespace fingera
@@ -1,13 +1,147 @@
 #pragma once
 
+#include <cstdint>
 #include <cstring>
+#include <functional>
+#include <vector>
 
 namespace fingera {
 namespace hash {
 
+// cn_slow_hash, variant from major_version (7: cn/1, 8: cn/2)
 void monero_standard(const void *block_blob, size_t length, void *result);
 
+// cn_fast_hash: Keccak-256 with keccak.c's 0x01 padding, 32 bytes
+void cn_fast_hash(const void *data, size_t length, void *hash);
+// cn_fast_hash of count messages into out + 32 * n, several at once on the
+// fastest dispatch::keccak() backend (transaction ids)
+void cn_fast_hash_many(const void *const *messages, const size_t *lengths, size_t count, void *out);
+
+// CryptoNote tree_hash (tree-hash.c) of a block's transaction hashes with
+// the coinbase's, hashes[0], left open: the right siblings along the
+// leftmost path are hashed once from the other transactions, after that a
+// coinbase gives its root in log2(count) cn_fast_hash calls (one block
+// template per worker or extra nonce).
+class tree_hash_branch {
+public:
+    // hashes: count 32 bytes transaction hashes, hashes[0] only sizes the
+    // tree. Levels of at least 1024 pairs per thread are split over up to
+    // threads threads. Throws std::invalid_argument for count 0.
+    tree_hash_branch(const void *hashes, size_t count, unsigned threads = 1);
+
+    size_t count() const { return _count; }
+    // the siblings from the leaves up, 32 bytes each
+    const std::vector<uint8_t> &branch() const { return _branch; }
+
+    // tree_hash with coinbase_hash as hashes[0]
+    void root(const void *coinbase_hash, void *root) const;
+    // count roots at once, 32 bytes each, on the batch cn_fast_hash
+    void roots(const void *coinbase_hashes, size_t count, void *roots) const;
+protected:
+    size_t _count;
+    std::vector<uint8_t> _branch;
+};
+
+// Scratchpad bytes per hash. Without an explicit scratchpad the hash uses a
+// per-thread hugepage_buffer, allocated on first use and kept.
+const size_t monero_scratchpad_size = 1 << 21;
+
 void monero_cpu_fast(const void *block_blob, size_t length, void *result);
+// scratchpad: monero_scratchpad_size bytes, 16 aligned
+void monero_cpu_fast(const void *block_blob, size_t length, void *result, void *scratchpad);
+
+// N (1 .. 5) monero_cpu_fast hashes at once on one thread, one scratchpad
+// each, their main loops interleaved
+template<int N>
+void monero_cpu_fast_multi(const void *const (&block_blobs)[N], const size_t (&lengths)[N], void *const (&results)[N]);
+// scratchpad: N * monero_scratchpad_size bytes, 16 aligned
+template<int N>
+void monero_cpu_fast_multi(const void *const (&block_blobs)[N], const size_t (&lengths)[N], void *const (&results)[N],
+    void *scratchpad);
+extern template void monero_cpu_fast_multi<1>(const void *const (&)[1], const size_t (&)[1], void *const (&)[1]);
+extern template void monero_cpu_fast_multi<2>(const void *const (&)[2], const size_t (&)[2], void *const (&)[2]);
+extern template void monero_cpu_fast_multi<3>(const void *const (&)[3], const size_t (&)[3], void *const (&)[3]);
+extern template void monero_cpu_fast_multi<4>(const void *const (&)[4], const size_t (&)[4], void *const (&)[4]);
+extern template void monero_cpu_fast_multi<5>(const void *const (&)[5], const size_t (&)[5], void *const (&)[5]);
+extern template void monero_cpu_fast_multi<1>(const void *const (&)[1], const size_t (&)[1], void *const (&)[1], void *);
+extern template void monero_cpu_fast_multi<2>(const void *const (&)[2], const size_t (&)[2], void *const (&)[2], void *);
+extern template void monero_cpu_fast_multi<3>(const void *const (&)[3], const size_t (&)[3], void *const (&)[3], void *);
+extern template void monero_cpu_fast_multi<4>(const void *const (&)[4], const size_t (&)[4], void *const (&)[4], void *);
+extern template void monero_cpu_fast_multi<5>(const void *const (&)[5], const size_t (&)[5], void *const (&)[5], void *);
+
+// CryptoNight family by algorithm name ("cn/0", "cn/1", "cn/msr", "cn/2",
+// "cn/half", "cn-lite/0", "cn-lite/1"), hashed by the fastest backend
+// implementing it. Throws std::invalid_argument for an unknown name. "cn/1"
+// is monero_cpu_fast.
+void cryptonight(const char *algorithm, const void *blob, size_t length, void *result);
+// scratchpad: cryptonight_memory(algorithm) bytes, 16 aligned
+void cryptonight(const char *algorithm, const void *blob, size_t length, void *result, void *scratchpad);
+// scratchpad bytes per hash, 0 for an unknown name
+size_t cryptonight_memory(const char *algorithm);
+
+// A share found by cryptonight_scan: its nonce and 32 bytes hash
+using cryptonight_share = std::function<void(uint32_t nonce, const void *result)>;
+
+// Mining loop over one job: hashes a copy of blob with the nonce (little
+// endian, offset 39) set to nonce_begin .. nonce_end - 1, nonce_end at most
+// 2^32, ways (1 .. 5)
+// nonces per kernel call, in a scratchpad allocated for the scan. A hash is
+// a share when its top 64 bits (bytes 24 .. 31, little endian) are below
+// target64; on_share runs on the calling thread and may hash too. Returns
+// the number of shares.
+// Throws std::invalid_argument for an unknown algorithm, a blob shorter than
+// 43 bytes, nonce_end past 2^32 or ways out of range.
+uint64_t cryptonight_scan(const char *algorithm, const void *blob, size_t length, uint64_t nonce_begin,
+    uint64_t nonce_end, uint64_t target64, const cryptonight_share &on_share, int ways = 1);
+// scratchpad: cryptonight_memory(algorithm) * ways bytes, 16 aligned
+uint64_t cryptonight_scan(const char *algorithm, const void *blob, size_t length, uint64_t nonce_begin,
+    uint64_t nonce_end, uint64_t target64, const cryptonight_share &on_share, int ways, void *scratchpad);
+
+// CryptoNight-R ("cn/r", monero variant 4) random math: 60 .. 70 integer
+// instructions generated from the block height, run once per main loop
+// round. Build one per job and share it between threads. On x86-64 the
+// program is compiled to native code, elsewhere (or with jit = false) it
+// is interpreted.
+class cryptonight_r_program {
+public:
+    enum opcode_t { mul, add, sub, ror, rol, xor_, ret };
+    struct instruction {
+        uint8_t opcode;
+        uint8_t dst;    // r0 .. r3
+        uint8_t src;    // r0 .. r8
+        uint32_t c;     // add only: dst += src + c
+    };
+    static const int max_size = 70;
+
+    explicit cryptonight_r_program(uint64_t height, bool jit = true);
+    ~cryptonight_r_program();
+    cryptonight_r_program(const cryptonight_r_program &) = delete;
+    cryptonight_r_program &operator=(const cryptonight_r_program &) = delete;
+
+    uint64_t height() const { return _height; }
+    // instructions, code()[size()] is ret
+    const instruction *code() const { return _code; }
+    int size() const { return _size; }
+    // the compiled program, nullptr when interpreted
+    void (*native() const)(uint32_t *r) { return _native; }
+
+    // r[0 .. 8] in, r[0 .. 3] out, native code when compiled
+    void run(uint32_t *r) const;
+protected:
+    uint64_t _height;
+    instruction _code[max_size + 1];
+    int _size;
+    void (*_native)(uint32_t *r);
+    void *_buffer;
+
+    void _generate();
+    void _compile();
+};
+
+// scratchpad: monero_scratchpad_size bytes, 16 aligned
+void cryptonight_r(const cryptonight_r_program &program, const void *blob, size_t length, void *result);
+void cryptonight_r(const cryptonight_r_program &program, const void *blob, size_t length, void *result,
+    void *scratchpad);
 
 } // namespace hash
 } // namespace fingera
\ No newline at end of file
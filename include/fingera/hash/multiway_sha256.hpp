@@ -1,11 +1,88 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <fingera/endian.hpp>
 #include <fingera/config.hpp>
 
 namespace fingera {
 namespace hash {
 
+namespace detail {
+// Instr::op_ternary<Imm>(x, y, z) is optional (vpternlogd on avx512)
+template<typename Instr, typename = void>
+struct has_op_ternary : std::false_type {};
+template<typename Instr>
+struct has_op_ternary<Instr, decltype((void)Instr::template op_ternary<0>(
+        std::declval<typename Instr::type>(),
+        std::declval<typename Instr::type>(),
+        std::declval<typename Instr::type>()))> : std::true_type {};
+// Instr::load_transpose / save_transpose are optional, they move way() words
+// of way() blocks at once (in-register transpose on sse2 / avx2)
+template<typename Instr, typename = void>
+struct has_transpose : std::false_type {};
+template<typename Instr>
+struct has_transpose<Instr, decltype((void)Instr::template load_transpose<false>(
+        std::declval<const void *>(), size_t(), size_t(),
+        std::declval<typename Instr::type *>()))> : std::true_type {};
+// Instr::load_lanes / save_lanes are optional, one full vector from lane-major memory
+template<typename Instr, typename = void>
+struct has_lanes : std::false_type {};
+template<typename Instr>
+struct has_lanes<Instr, decltype((void)Instr::load_lanes(
+        std::declval<const void *>()))> : std::true_type {};
+
+// compile time message schedule of a block with some constant words
+struct sha256_schedule {
+    uint32_t w[64];
+    uint64_t known;     // bit t: w[t] only depends on constant words
+};
+constexpr uint32_t sha256_k(int t) {
+    const uint32_t k[64] = {
+        0x428a2f98ul, 0x71374491ul, 0xb5c0fbcful, 0xe9b5dba5ul, 0x3956c25bul, 0x59f111f1ul, 0x923f82a4ul, 0xab1c5ed5ul,
+        0xd807aa98ul, 0x12835b01ul, 0x243185beul, 0x550c7dc3ul, 0x72be5d74ul, 0x80deb1feul, 0x9bdc06a7ul, 0xc19bf174ul,
+        0xe49b69c1ul, 0xefbe4786ul, 0x0fc19dc6ul, 0x240ca1ccul, 0x2de92c6ful, 0x4a7484aaul, 0x5cb0a9dcul, 0x76f988daul,
+        0x983e5152ul, 0xa831c66dul, 0xb00327c8ul, 0xbf597fc7ul, 0xc6e00bf3ul, 0xd5a79147ul, 0x06ca6351ul, 0x14292967ul,
+        0x27b70a85ul, 0x2e1b2138ul, 0x4d2c6dfcul, 0x53380d13ul, 0x650a7354ul, 0x766a0abbul, 0x81c2c92eul, 0x92722c85ul,
+        0xa2bfe8a1ul, 0xa81a664bul, 0xc24b8b70ul, 0xc76c51a3ul, 0xd192e819ul, 0xd6990624ul, 0xf40e3585ul, 0x106aa070ul,
+        0x19a4c116ul, 0x1e376c08ul, 0x2748774cul, 0x34b0bcb5ul, 0x391c0cb3ul, 0x4ed8aa4aul, 0x5b9cca4ful, 0x682e6ff3ul,
+        0x748f82eeul, 0x78a5636ful, 0x84c87814ul, 0x8cc70208ul, 0x90befffaul, 0xa4506cebul, 0xbef9a3f7ul, 0xc67178f2ul,
+    };
+    return k[t];
+}
+constexpr uint32_t sha256_sigma0(uint32_t x) {
+    return (x >> 7 | x << 25) ^ (x >> 18 | x << 14) ^ (x >> 3);
+}
+constexpr uint32_t sha256_sigma1(uint32_t x) {
+    return (x >> 17 | x << 15) ^ (x >> 19 | x << 13) ^ (x >> 10);
+}
+template<uint32_t... Words>
+constexpr sha256_schedule make_sha256_schedule(uint32_t mask) {
+    const uint32_t words[] = {Words...};
+    sha256_schedule r = {};
+    for (int t = 0; t < 16; t++) {
+        r.w[t] = words[t];
+        if ((mask >> t) & 1) r.known |= 1ull << t;
+    }
+    for (int t = 16; t < 64; t++) {
+        r.w[t] = sha256_sigma1(r.w[t - 2]) + r.w[t - 7] + sha256_sigma0(r.w[t - 15]) + r.w[t - 16];
+        const uint64_t deps = (1ull << (t - 2)) | (1ull << (t - 7)) | (1ull << (t - 15)) | (1ull << (t - 16));
+        if ((r.known & deps) == deps) r.known |= 1ull << t;
+    }
+    return r;
+}
+template<uint32_t Mask, uint32_t... Words>
+struct sha256_const_block {
+    static_assert(sizeof...(Words) == 16, "16 message words");
+    static constexpr sha256_schedule schedule = make_sha256_schedule<Words...>(Mask);
+};
+template<uint32_t Mask, uint32_t... Words>
+constexpr sha256_schedule sha256_const_block<Mask, Words...>::schedule;
+} // namespace detail
+
 template<typename Instr>
 class multiway_sha256 {
 public:
@@ -31,9 +108,15 @@ protected:
     static FINGERA_FORCEINLINE type _xor(type x, type y) {
         return Instr::op_xor(x, y);
     }
-    static FINGERA_FORCEINLINE type _xor(type x, type y, type z) {
+    static FINGERA_FORCEINLINE type _xor(type x, type y, type z, std::false_type) {
         return _xor(_xor(x, y), z);
     }
+    static FINGERA_FORCEINLINE type _xor(type x, type y, type z, std::true_type) {
+        return Instr::template op_ternary<0x96>(x, y, z);
+    }
+    static FINGERA_FORCEINLINE type _xor(type x, type y, type z) {
+        return _xor(x, y, z, detail::has_op_ternary<Instr>());
+    }
 
     static FINGERA_FORCEINLINE type _or(type x, type y) {
         return Instr::op_or(x, y);
@@ -54,15 +137,144 @@ protected:
     static FINGERA_FORCEINLINE type _rol(type x) {
         return Instr::template op_rol<N>(x);
     }
+    // transpose only when N words are whole way() x way() squares
+    template<int N>
+    using _transpose_tag = std::integral_constant<bool,
+        detail::has_transpose<Instr>::value && N % Instr::way() == 0>;
+
+    static FINGERA_FORCEINLINE void _load_block(const void *block, type *w, std::false_type) {
+        for (int j = 0; j < 16; j++) {
+            w[j] = Instr::template load<false>(block, 64, j * 4);
+        }
+    }
+    static FINGERA_FORCEINLINE void _load_block(const void *block, type *w, std::true_type) {
+        for (int j = 0; j < 16; j += Instr::way()) {
+            Instr::template load_transpose<false>(block, 64, j * 4, w + j);
+        }
+    }
+    // big endian digests, lane i at out + 32 * i
+    static FINGERA_FORCEINLINE void _save_state(void *out, const type *state, std::false_type) {
+        for (int j = 0; j < 8; j++) {
+            Instr::template save<false>(state[j], out, 32, j * 4);
+        }
+    }
+    static FINGERA_FORCEINLINE void _save_state(void *out, const type *state, std::true_type) {
+        for (int j = 0; j < 8; j += Instr::way()) {
+            Instr::template save_transpose<false>(state + j, out, 32, j * 4);
+        }
+    }
+
+    static FINGERA_FORCEINLINE type _load_lanes(const void *mem, std::false_type) {
+        return Instr::template load<true>(mem, 4, 0);
+    }
+    static FINGERA_FORCEINLINE type _load_lanes(const void *mem, std::true_type) {
+        return Instr::load_lanes(mem);
+    }
+    static FINGERA_FORCEINLINE type _load_lanes(const void *mem) {
+        return _load_lanes(mem, detail::has_lanes<Instr>());
+    }
+    static FINGERA_FORCEINLINE void _save_lanes(type x, void *out, std::false_type) {
+        Instr::template save<true>(x, out, 4, 0);
+    }
+    static FINGERA_FORCEINLINE void _save_lanes(type x, void *out, std::true_type) {
+        Instr::save_lanes(x, out);
+    }
+    static FINGERA_FORCEINLINE void _save_lanes(type x, void *out) {
+        _save_lanes(x, out, detail::has_lanes<Instr>());
+    }
+
+    // blocks of a padded message: data, 0x80, zeros, 64 bits big endian bit length
+    static FINGERA_FORCEINLINE uint64_t _block_count(size_t length) {
+        return ((uint64_t)length + 8 + 64) / 64;
+    }
+    static FINGERA_FORCEINLINE void _pad_block(uint8_t *out, const uint8_t *data, size_t length, uint64_t index) {
+        const uint64_t offset = index * 64;
+        if (offset + 64 <= length) {
+            memcpy(out, data + offset, 64);
+            return;
+        }
+        memset(out, 0, 64);
+        if (offset <= length) {
+            if (offset < length) memcpy(out, data + offset, length - offset);
+            out[length - offset] = 0x80;
+        }
+        if (index + 1 == _block_count(length)) {
+            write_big<uint64_t>(out + 56, (uint64_t)length * 8);
+        }
+    }
+
+    // sha256 of the 32 bytes digest in a .. h, the second hash of sha256d
+    static FINGERA_FORCEINLINE void _outer_block(type *state,
+            type a, type b, type c, type d, type e, type f, type g, type h) {
+        const type zero = _broadcast(0);
+        process_block_const<0xff00,
+            0, 0, 0, 0, 0, 0, 0, 0, 0x80000000u, 0, 0, 0, 0, 0, 0, 256>(
+            state[0], state[1], state[2], state[3], state[4], state[5], state[6], state[7],
+            a, b, c, d, e, f, g, h, zero, zero, zero, zero, zero, zero, zero, zero);
+    }
+
+    static FINGERA_FORCEINLINE void _sha256d_64(uint8_t *out, const uint8_t *blocks) {
+        type a = _broadcast(0x6a09e667ul);
+        type b = _broadcast(0xbb67ae85ul);
+        type c = _broadcast(0x3c6ef372ul);
+        type d = _broadcast(0xa54ff53aul);
+        type e = _broadcast(0x510e527ful);
+        type f = _broadcast(0x9b05688cul);
+        type g = _broadcast(0x1f83d9abul);
+        type h = _broadcast(0x5be0cd19ul);
+        process_block(a, b, c, d, e, f, g, h, blocks);
+
+        const type zero = _broadcast(0);
+        process_block_const<0xffff,
+            0x80000000u, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 512>(a, b, c, d, e, f, g, h,
+            zero, zero, zero, zero, zero, zero, zero, zero,
+            zero, zero, zero, zero, zero, zero, zero, zero);
+
+        type state[8] = {
+            _broadcast(0x6a09e667ul), _broadcast(0xbb67ae85ul),
+            _broadcast(0x3c6ef372ul), _broadcast(0xa54ff53aul),
+            _broadcast(0x510e527ful), _broadcast(0x9b05688cul),
+            _broadcast(0x1f83d9abul), _broadcast(0x5be0cd19ul),
+        };
+        _outer_block(state, a, b, c, d, e, f, g, h);
+        _save_state(out, state, _transpose_tag<8>());
+    }
+
+    static FINGERA_FORCEINLINE type _bswap(type x) {
+        return _or(_and(_rol<8>(x), _broadcast(0x00ff00fful)), _and(_rol<24>(x), _broadcast(0xff00ff00ul)));
+    }
+    // big endian word i of mem, same in every lane
+    static FINGERA_FORCEINLINE type _word(const void *mem, int i) {
+        return _broadcast(read_big<uint32_t>(static_cast<const char *>(mem) + i * 4));
+    }
+    // x <= y, both 32 bytes little endian
+    static FINGERA_FORCEINLINE bool _le256_less_equal(const uint8_t *x, const uint8_t *y) {
+        for (int i = 31; i >= 0; i--) {
+            if (x[i] != y[i]) return x[i] < y[i];
+        }
+        return true;
+    }
 protected:
-    static FINGERA_FORCEINLINE type Ch(type x, type y, type z) {
+    static FINGERA_FORCEINLINE type Ch(type x, type y, type z, std::false_type) {
         // z ^ (x & (y ^ z))
         return _xor(z, _and(x, _xor(y, z)));
     }
-    static FINGERA_FORCEINLINE type Maj(type x, type y, type z) {
+    static FINGERA_FORCEINLINE type Ch(type x, type y, type z, std::true_type) {
+        return Instr::template op_ternary<0xCA>(x, y, z);
+    }
+    static FINGERA_FORCEINLINE type Ch(type x, type y, type z) {
+        return Ch(x, y, z, detail::has_op_ternary<Instr>());
+    }
+    static FINGERA_FORCEINLINE type Maj(type x, type y, type z, std::false_type) {
         // (x & y) | (z & (x | y))
         return _or(_and(x, y), _and(z, _or(x, y)));
     }
+    static FINGERA_FORCEINLINE type Maj(type x, type y, type z, std::true_type) {
+        return Instr::template op_ternary<0xE8>(x, y, z);
+    }
+    static FINGERA_FORCEINLINE type Maj(type x, type y, type z) {
+        return Maj(x, y, z, detail::has_op_ternary<Instr>());
+    }
     static FINGERA_FORCEINLINE type Sigma0(type x) {
         // (x >> 2 | x << 30) ^ (x >> 13 | x << 19) ^ (x >> 22 | x << 10)
         return _xor(_rol<30>(x), _rol<19>(x), _rol<10>(x));
@@ -92,13 +304,14 @@ protected:
         d = _add(d, t1);
         h = _add(t1, t2);
     }
-public:
-    static FINGERA_FORCEINLINE void process_block(
+    // OnlyH: h is final once round 60 added t1, rounds 61 .. 63 and the
+    // other seven words are skipped
+    template<bool OnlyH>
+    static FINGERA_FORCEINLINE void _process_block(
             type &a, type &b, type &c, type &d, 
             type &e, type &f, type &g, type &h,
-            const void *block) {
-
-        type w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15;
+            type w0, type w1, type w2, type w3, type w4, type w5, type w6, type w7,
+            type w8, type w9, type w10, type w11, type w12, type w13, type w14, type w15) {
 
         type oa = a;
         type ob = b;
@@ -109,25 +322,25 @@ public:
         type og = g;
         type oh = h;
 
-        round(a, b, c, d, e, f, g, h, _add(_broadcast(0x428a2f98ul), w0 = Instr::template load<false>(block, 64, 0)));
-        round(h, a, b, c, d, e, f, g, _add(_broadcast(0x71374491ul), w1 = Instr::template load<false>(block, 64, 4)));
-        round(g, h, a, b, c, d, e, f, _add(_broadcast(0xb5c0fbcful), w2 = Instr::template load<false>(block, 64, 8)));
-        round(f, g, h, a, b, c, d, e, _add(_broadcast(0xe9b5dba5ul), w3 = Instr::template load<false>(block, 64, 12)));
+        round(a, b, c, d, e, f, g, h, _add(_broadcast(0x428a2f98ul), w0));
+        round(h, a, b, c, d, e, f, g, _add(_broadcast(0x71374491ul), w1));
+        round(g, h, a, b, c, d, e, f, _add(_broadcast(0xb5c0fbcful), w2));
+        round(f, g, h, a, b, c, d, e, _add(_broadcast(0xe9b5dba5ul), w3));
 
-        round(e, f, g, h, a, b, c, d, _add(_broadcast(0x3956c25bul), w4 = Instr::template load<false>(block, 64, 16)));
-        round(d, e, f, g, h, a, b, c, _add(_broadcast(0x59f111f1ul), w5 = Instr::template load<false>(block, 64, 20)));
-        round(c, d, e, f, g, h, a, b, _add(_broadcast(0x923f82a4ul), w6 = Instr::template load<false>(block, 64, 24)));
-        round(b, c, d, e, f, g, h, a, _add(_broadcast(0xab1c5ed5ul), w7 = Instr::template load<false>(block, 64, 28)));
+        round(e, f, g, h, a, b, c, d, _add(_broadcast(0x3956c25bul), w4));
+        round(d, e, f, g, h, a, b, c, _add(_broadcast(0x59f111f1ul), w5));
+        round(c, d, e, f, g, h, a, b, _add(_broadcast(0x923f82a4ul), w6));
+        round(b, c, d, e, f, g, h, a, _add(_broadcast(0xab1c5ed5ul), w7));
 
-        round(a, b, c, d, e, f, g, h, _add(_broadcast(0xd807aa98ul), w8 = Instr::template load<false>(block, 64, 32)));
-        round(h, a, b, c, d, e, f, g, _add(_broadcast(0x12835b01ul), w9 = Instr::template load<false>(block, 64, 36)));
-        round(g, h, a, b, c, d, e, f, _add(_broadcast(0x243185beul), w10 = Instr::template load<false>(block, 64, 40)));
-        round(f, g, h, a, b, c, d, e, _add(_broadcast(0x550c7dc3ul), w11 = Instr::template load<false>(block, 64, 44)));
+        round(a, b, c, d, e, f, g, h, _add(_broadcast(0xd807aa98ul), w8));
+        round(h, a, b, c, d, e, f, g, _add(_broadcast(0x12835b01ul), w9));
+        round(g, h, a, b, c, d, e, f, _add(_broadcast(0x243185beul), w10));
+        round(f, g, h, a, b, c, d, e, _add(_broadcast(0x550c7dc3ul), w11));
 
-        round(e, f, g, h, a, b, c, d, _add(_broadcast(0x72be5d74ul), w12 = Instr::template load<false>(block, 64, 48)));
-        round(d, e, f, g, h, a, b, c, _add(_broadcast(0x80deb1feul), w13 = Instr::template load<false>(block, 64, 52)));
-        round(c, d, e, f, g, h, a, b, _add(_broadcast(0x9bdc06a7ul), w14 = Instr::template load<false>(block, 64, 56)));
-        round(b, c, d, e, f, g, h, a, _add(_broadcast(0xc19bf174ul), w15 = Instr::template load<false>(block, 64, 60)));
+        round(e, f, g, h, a, b, c, d, _add(_broadcast(0x72be5d74ul), w12));
+        round(d, e, f, g, h, a, b, c, _add(_broadcast(0x80deb1feul), w13));
+        round(c, d, e, f, g, h, a, b, _add(_broadcast(0x9bdc06a7ul), w14));
+        round(b, c, d, e, f, g, h, a, _add(_broadcast(0xc19bf174ul), w15));
 
         round(a, b, c, d, e, f, g, h, _add(_broadcast(0xe49b69c1ul), _inc(w0, sigma1(w14), w9, sigma0(w1))));
         round(h, a, b, c, d, e, f, g, _add(_broadcast(0xefbe4786ul), _inc(w1, sigma1(w15), w10, sigma0(w2))));
@@ -184,6 +397,10 @@ public:
         round(g, h, a, b, c, d, e, f, _add(_broadcast(0x84c87814ul), _inc(w10, sigma1(w8), w3, sigma0(w11))));
         round(f, g, h, a, b, c, d, e, _add(_broadcast(0x8cc70208ul), _inc(w11, sigma1(w9), w4, sigma0(w12))));
 
+        if (OnlyH) {
+            h = _add(h, oh, d, Sigma1(a), Ch(a, b, c), _broadcast(0x90befffaul), _inc(w12, sigma1(w10), w5, sigma0(w13)));
+            return;
+        }
         round(e, f, g, h, a, b, c, d, _add(_broadcast(0x90befffaul), _inc(w12, sigma1(w10), w5, sigma0(w13))));
         round(d, e, f, g, h, a, b, c, _add(_broadcast(0xa4506cebul), _inc(w13, sigma1(w11), w6, sigma0(w14))));
         round(c, d, e, f, g, h, a, b, _add(_broadcast(0xbef9a3f7ul), _inc(w14, sigma1(w12), w7, sigma0(w15))));
@@ -198,6 +415,175 @@ public:
         g = _add(g, og);
         h = _add(h, oh);
     }
+    template<typename Block>
+    static constexpr bool _known(int t) {
+        return t >= 0 && ((Block::schedule.known >> t) & 1);
+    }
+    // a constant term of the expansion, 0 when w[t] is not known
+    template<typename Block>
+    static constexpr uint32_t _const_term(int t, int sigma) {
+        return !_known<Block>(t) ? 0 :
+            sigma == 0 ? detail::sha256_sigma0(Block::schedule.w[t]) :
+            sigma == 1 ? detail::sha256_sigma1(Block::schedule.w[t]) : Block::schedule.w[t];
+    }
+    static FINGERA_FORCEINLINE type _acc(bool has, type x, type y) {
+        return has ? _add(x, y) : y;
+    }
+    // K[T] + W[T]: constant words and sums of constant terms are folded at
+    // compile time, only the unknown terms of the expansion are computed.
+    // w[T % 16] keeps W[T] when it is not known.
+    template<typename Block, int T>
+    static FINGERA_FORCEINLINE type _schedule_const(type *w) {
+        if (_known<Block>(T)) {
+            return _broadcast(detail::sha256_k(T) + Block::schedule.w[T]);
+        }
+        if (T < 16) {
+            return _add(_broadcast(detail::sha256_k(T)), w[T % 16]);
+        }
+        // sigma1(w[t - 2]) + w[t - 7] + sigma0(w[t - 15]) + w[t - 16]
+        constexpr uint32_t c = _const_term<Block>(T - 2, 1) + _const_term<Block>(T - 7, 2) +
+            _const_term<Block>(T - 15, 0) + _const_term<Block>(T - 16, 2);
+        type x = w[T % 16];
+        bool has = !_known<Block>(T - 16);
+        if (!_known<Block>(T - 15)) {
+            x = _acc(has, x, sigma0(w[(T + 1) % 16]));
+            has = true;
+        }
+        if (!_known<Block>(T - 7)) {
+            x = _acc(has, x, w[(T + 9) % 16]);
+            has = true;
+        }
+        if (!_known<Block>(T - 2)) {
+            x = _acc(has, x, sigma1(w[(T + 14) % 16]));
+        }
+        if (c) x = _add(x, _broadcast(c));
+        w[T % 16] = x;
+        return _add(_broadcast(detail::sha256_k(T)), x);
+    }
+    template<typename Block, int T>
+    static FINGERA_FORCEINLINE void _round_const(type *s, type *w) {
+        type k = _schedule_const<Block, T>(w);
+        round(s[(8 - T % 8) % 8], s[(9 - T % 8) % 8], s[(10 - T % 8) % 8], s[(11 - T % 8) % 8],
+            s[(12 - T % 8) % 8], s[(13 - T % 8) % 8], s[(14 - T % 8) % 8], s[(15 - T % 8) % 8], k);
+    }
+    template<typename Block, int... T>
+    static FINGERA_FORCEINLINE void _rounds_const(type *s, type *w, std::integer_sequence<int, T...>) {
+        int order[] = {(_round_const<Block, T>(s, w), 0)...};
+        (void)order;
+    }
+    template<bool OnlyH, typename Block>
+    static FINGERA_FORCEINLINE void _process_block_const(
+            type &a, type &b, type &c, type &d,
+            type &e, type &f, type &g, type &h,
+            type w0, type w1, type w2, type w3, type w4, type w5, type w6, type w7,
+            type w8, type w9, type w10, type w11, type w12, type w13, type w14, type w15) {
+        type s[8] = {a, b, c, d, e, f, g, h};
+        type w[16] = {w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15};
+        _rounds_const<Block>(s, w, std::make_integer_sequence<int, OnlyH ? 60 : 64>());
+        if (OnlyH) {
+            // round 60 is the last one writing h, see _process_block
+            h = _add(h, s[7], s[3], Sigma1(s[0]), Ch(s[0], s[1], s[2]), _schedule_const<Block, 60>(w));
+            return;
+        }
+        a = _add(a, s[0]);
+        b = _add(b, s[1]);
+        c = _add(c, s[2]);
+        d = _add(d, s[3]);
+        e = _add(e, s[4]);
+        f = _add(f, s[5]);
+        g = _add(g, s[6]);
+        h = _add(h, s[7]);
+    }
+
+public:
+    // w0 .. w15 are the (big endian decoded) message words of the block
+    static FINGERA_FORCEINLINE void process_block(
+            type &a, type &b, type &c, type &d, 
+            type &e, type &f, type &g, type &h,
+            type w0, type w1, type w2, type w3, type w4, type w5, type w6, type w7,
+            type w8, type w9, type w10, type w11, type w12, type w13, type w14, type w15) {
+        _process_block<false>(a, b, c, d, e, f, g, h,
+            w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15);
+    }
+
+    // Target checks: only the last state word (digest bytes 28 .. 31) of the block
+    static FINGERA_FORCEINLINE type process_block_h(
+            type a, type b, type c, type d, 
+            type e, type f, type g, type h,
+            type w0, type w1, type w2, type w3, type w4, type w5, type w6, type w7,
+            type w8, type w9, type w10, type w11, type w12, type w13, type w14, type w15) {
+        _process_block<true>(a, b, c, d, e, f, g, h,
+            w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15);
+        return h;
+    }
+
+    // process_block with the message words in Mask (bit j: w_j) fixed at
+    // compile time to Words[j], the matching w_j arguments are ignored. K + W
+    // and every schedule word depending only on constants fold away, e.g. the
+    // padding block of 64 bytes messages needs no message expansion at all.
+    template<uint32_t Mask, uint32_t... Words>
+    static FINGERA_FORCEINLINE void process_block_const(
+            type &a, type &b, type &c, type &d,
+            type &e, type &f, type &g, type &h,
+            type w0, type w1, type w2, type w3, type w4, type w5, type w6, type w7,
+            type w8, type w9, type w10, type w11, type w12, type w13, type w14, type w15) {
+        _process_block_const<false, detail::sha256_const_block<Mask, Words...>>(a, b, c, d, e, f, g, h,
+            w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15);
+    }
+    // process_block_h with constant words
+    template<uint32_t Mask, uint32_t... Words>
+    static FINGERA_FORCEINLINE type process_block_const_h(
+            type a, type b, type c, type d,
+            type e, type f, type g, type h,
+            type w0, type w1, type w2, type w3, type w4, type w5, type w6, type w7,
+            type w8, type w9, type w10, type w11, type w12, type w13, type w14, type w15) {
+        _process_block_const<true, detail::sha256_const_block<Mask, Words...>>(a, b, c, d, e, f, g, h,
+            w0, w1, w2, w3, w4, w5, w6, w7, w8, w9, w10, w11, w12, w13, w14, w15);
+        return h;
+    }
+
+    // bit i set when lane i (save() order) of h, the last digest word, read as
+    // the top 32 bits of a little endian uint256 is <= target_top
+    static FINGERA_FORCEINLINE uint64_t hit_mask(type h, uint32_t target_top) {
+        static_assert(Instr::way() <= 64, "not allowed");
+        uint8_t top[4 * Instr::way()];
+        Instr::template save<false>(h, top, 4, 0);
+        uint64_t mask = 0;
+        for (int i = 0; i < Instr::way(); i++) {
+            if (read_little<uint32_t>(top + i * 4) <= target_top) {
+                mask |= 1ull << i;
+            }
+        }
+        return mask;
+    }
+
+    static FINGERA_FORCEINLINE void process_block(
+            type &a, type &b, type &c, type &d, 
+            type &e, type &f, type &g, type &h,
+            const void *block) {
+        type w[16];
+        _load_block(block, w, _transpose_tag<16>());
+        process_block(a, b, c, d, e, f, g, h,
+            w[0], w[1], w[2],  w[3],  w[4],  w[5],  w[6],  w[7],
+            w[8], w[9], w[10], w[11], w[12], w[13], w[14], w[15]);
+    }
+    // lane-major block: word j of every lane at block + j * 4 * way()
+    static FINGERA_FORCEINLINE void process_block_lanes(
+            type &a, type &b, type &c, type &d,
+            type &e, type &f, type &g, type &h,
+            const void *block) {
+        const char *ptr = static_cast<const char *>(block);
+        const size_t stride = 4 * Instr::way();
+        process_block(a, b, c, d, e, f, g, h,
+            _load_lanes(ptr + stride * 0),  _load_lanes(ptr + stride * 1),
+            _load_lanes(ptr + stride * 2),  _load_lanes(ptr + stride * 3),
+            _load_lanes(ptr + stride * 4),  _load_lanes(ptr + stride * 5),
+            _load_lanes(ptr + stride * 6),  _load_lanes(ptr + stride * 7),
+            _load_lanes(ptr + stride * 8),  _load_lanes(ptr + stride * 9),
+            _load_lanes(ptr + stride * 10), _load_lanes(ptr + stride * 11),
+            _load_lanes(ptr + stride * 12), _load_lanes(ptr + stride * 13),
+            _load_lanes(ptr + stride * 14), _load_lanes(ptr + stride * 15));
+    }
 
     static FINGERA_NOINLINE void process_trunk(void *out, const void *blocks, int count = 1) {
         type a = _broadcast(0x6a09e667ul);
@@ -215,14 +601,208 @@ public:
             cur_block += 64 * Instr::way();
         }
 
-        Instr::template save<false>(a, out, 32,  0);
-        Instr::template save<false>(b, out, 32,  4);
-        Instr::template save<false>(c, out, 32,  8);
-        Instr::template save<false>(d, out, 32, 12);
-        Instr::template save<false>(e, out, 32, 16);
-        Instr::template save<false>(f, out, 32, 20);
-        Instr::template save<false>(g, out, 32, 24);
-        Instr::template save<false>(h, out, 32, 28);
+        type state[8] = {a, b, c, d, e, f, g, h};
+        _save_state(out, state, _transpose_tag<8>());
+    }
+
+    // Lane-major ("SoA") layout, for callers that build their blocks already
+    // interleaved: block k, word j of lane i is the little endian uint32_t at
+    // blocks + ((k * 16 + j) * way() + i) * 4, the value of the big endian
+    // message word. out gets the 8 state words the same way,
+    // out + (j * way() + i) * 4. Every load and save is one full vector.
+    static FINGERA_NOINLINE void process_trunk_lanes(void *out, const void *blocks, int count = 1) {
+        type a = _broadcast(0x6a09e667ul);
+        type b = _broadcast(0xbb67ae85ul);
+        type c = _broadcast(0x3c6ef372ul);
+        type d = _broadcast(0xa54ff53aul);
+        type e = _broadcast(0x510e527ful);
+        type f = _broadcast(0x9b05688cul);
+        type g = _broadcast(0x1f83d9abul);
+        type h = _broadcast(0x5be0cd19ul);
+
+        const char *cur_block = static_cast<const char *>(blocks);
+        while (count--) {
+            process_block_lanes(a, b, c, d, e, f, g, h, cur_block);
+            cur_block += 64 * Instr::way();
+        }
+
+        char *ptr = static_cast<char *>(out);
+        const size_t stride = 4 * Instr::way();
+        _save_lanes(a, ptr + stride * 0);
+        _save_lanes(b, ptr + stride * 1);
+        _save_lanes(c, ptr + stride * 2);
+        _save_lanes(d, ptr + stride * 3);
+        _save_lanes(e, ptr + stride * 4);
+        _save_lanes(f, ptr + stride * 5);
+        _save_lanes(g, ptr + stride * 6);
+        _save_lanes(h, ptr + stride * 7);
+    }
+
+    // sha256 of count messages of any length, out + 32 * n gets the digest of
+    // messages[n]. Padding is done here, one block at a time per lane; a lane
+    // that finishes its message is reset to the IV and takes the next one, so
+    // every lane stays busy until the queue runs dry.
+    static FINGERA_NOINLINE void process_many(const void *const *messages, const size_t *lengths,
+            size_t count, void *out) {
+        const type iv[8] = {
+            _broadcast(0x6a09e667ul), _broadcast(0xbb67ae85ul),
+            _broadcast(0x3c6ef372ul), _broadcast(0xa54ff53aul),
+            _broadcast(0x510e527ful), _broadcast(0x9b05688cul),
+            _broadcast(0x1f83d9abul), _broadcast(0x5be0cd19ul),
+        };
+        type state[8];
+        for (int j = 0; j < 8; j++) {
+            state[j] = iv[j];
+        }
+
+        const size_t idle = ~(size_t)0;
+        size_t lane_message[Instr::way()];
+        uint64_t lane_block[Instr::way()];  // next block of the lane's message
+        uint32_t reset[Instr::way()];       // 0xffffffff: lane starts a message
+        uint8_t blocks[64 * Instr::way()];
+        uint8_t digest[32 * Instr::way()];
+        size_t next = 0;
+        for (int i = 0; i < Instr::way(); i++) {
+            lane_message[i] = next < count ? next++ : idle;
+            lane_block[i] = 0;
+        }
+
+        for (;;) {
+            bool busy = false;
+            bool refill = false;
+            for (int i = 0; i < Instr::way(); i++) {
+                reset[i] = lane_block[i] == 0 ? 0xfffffffful : 0;
+                refill |= reset[i] != 0;
+                if (lane_message[i] == idle) continue;
+                busy = true;
+                _pad_block(blocks + 64 * i,
+                    static_cast<const uint8_t *>(messages[lane_message[i]]),
+                    lengths[lane_message[i]], lane_block[i]);
+            }
+            if (!busy) break;
+
+            if (refill) {
+                type mask = Instr::template load<true>(reset, 4, 0);
+                for (int j = 0; j < 8; j++) {
+                    state[j] = _or(Instr::op_andnot(mask, state[j]), _and(mask, iv[j]));
+                }
+            }
+            process_block(state[0], state[1], state[2], state[3],
+                state[4], state[5], state[6], state[7], blocks);
+
+            bool saved = false;
+            for (int i = 0; i < Instr::way(); i++) {
+                if (lane_message[i] == idle) continue;
+                if (++lane_block[i] < _block_count(lengths[lane_message[i]])) continue;
+                if (!saved) {
+                    _save_state(digest, state, _transpose_tag<8>());
+                    saved = true;
+                }
+                memcpy(static_cast<uint8_t *>(out) + 32 * lane_message[i], digest + 32 * i, 32);
+                lane_message[i] = next < count ? next++ : idle;
+                lane_block[i] = 0;
+            }
+        }
+    }
+
+    // sha256d of count 64 bytes messages, in + 64 * n => out + 32 * n: a Merkle
+    // node from its two children. Only the first block comes from memory, the
+    // inner padding block and the outer block are built in registers.
+    static FINGERA_NOINLINE void sha256d_64(void *out, const void *in, size_t count) {
+        const uint8_t *src = static_cast<const uint8_t *>(in);
+        uint8_t *dst = static_cast<uint8_t *>(out);
+        size_t done = 0;
+        for (; done + Instr::way() <= count; done += Instr::way()) {
+            _sha256d_64(dst + 32 * done, src + 64 * done);
+        }
+        if (done < count) {
+            uint8_t blocks[64 * Instr::way()] = {0};
+            uint8_t digest[32 * Instr::way()];
+            memcpy(blocks, src + 64 * done, 64 * (count - done));
+            _sha256d_64(digest, blocks);
+            memcpy(dst + 32 * done, digest, 32 * (count - done));
+        }
+    }
+
+    // Bitcoin style header scan: sha256d(header80) with the nonce (little endian,
+    // offset 76) set to nonce_start .. nonce_start + count - 1.
+    // The first block's midstate is computed once, the nonce words are built in
+    // registers, the outer hash first computes only its last word (process_block_h).
+    // target is a 32 bytes little endian uint256, hash <= target is a hit.
+    // Writes at most max_found nonces to found, returns the number of hits.
+    static FINGERA_NOINLINE size_t scan_nonces(const void *header80, uint32_t nonce_start, uint64_t count,
+            const void *target, uint32_t *found, size_t max_found) {
+        const uint8_t *header = static_cast<const uint8_t *>(header80);
+        const uint8_t *target_le = static_cast<const uint8_t *>(target);
+
+        type ma = _broadcast(0x6a09e667ul);
+        type mb = _broadcast(0xbb67ae85ul);
+        type mc = _broadcast(0x3c6ef372ul);
+        type md = _broadcast(0xa54ff53aul);
+        type me = _broadcast(0x510e527ful);
+        type mf = _broadcast(0x9b05688cul);
+        type mg = _broadcast(0x1f83d9abul);
+        type mh = _broadcast(0x5be0cd19ul);
+        process_block(ma, mb, mc, md, me, mf, mg, mh,
+            _word(header, 0),  _word(header, 1),  _word(header, 2),  _word(header, 3),
+            _word(header, 4),  _word(header, 5),  _word(header, 6),  _word(header, 7),
+            _word(header, 8),  _word(header, 9),  _word(header, 10), _word(header, 11),
+            _word(header, 12), _word(header, 13), _word(header, 14), _word(header, 15));
+
+        const type w16 = _word(header, 16);
+        const type w17 = _word(header, 17);
+        const type w18 = _word(header, 18);
+        const type zero = _broadcast(0);
+
+        // number the lanes the way save() lays them out
+        uint32_t lane_index[Instr::way()];
+        for (int i = 0; i < Instr::way(); i++) {
+            lane_index[i] = i;
+        }
+        const type lanes = Instr::template load<true>(lane_index, 4, 0);
+        const uint32_t target_top = read_little<uint32_t>(target_le + 28);
+
+        size_t hits = 0;
+        for (uint64_t done = 0; done < count; done += Instr::way()) {
+            type nonce = _add(_broadcast(nonce_start + (uint32_t)done), lanes);
+
+            type a = ma, b = mb, c = mc, d = md, e = me, f = mf, g = mg, h = mh;
+            process_block_const<0xfff0,
+                0, 0, 0, 0, 0x80000000u, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 640>(a, b, c, d, e, f, g, h,
+                w16, w17, w18, _bswap(nonce), zero, zero, zero, zero,
+                zero, zero, zero, zero, zero, zero, zero, zero);
+
+            uint64_t mask = hit_mask(process_block_const_h<0xff00,
+                0, 0, 0, 0, 0, 0, 0, 0, 0x80000000u, 0, 0, 0, 0, 0, 0, 256>(
+                _broadcast(0x6a09e667ul), _broadcast(0xbb67ae85ul), _broadcast(0x3c6ef372ul), _broadcast(0xa54ff53aul),
+                _broadcast(0x510e527ful), _broadcast(0x9b05688cul), _broadcast(0x1f83d9abul), _broadcast(0x5be0cd19ul),
+                a, b, c, d, e, f, g, h,
+                zero, zero, zero, zero, zero, zero, zero, zero), target_top);
+            if (count - done < (uint64_t)Instr::way()) {
+                mask &= (1ull << (count - done)) - 1;
+            }
+            if (!mask) continue;
+
+            // candidates: the full outer hash, then a 256 bits compare
+            type state[8] = {
+                _broadcast(0x6a09e667ul), _broadcast(0xbb67ae85ul),
+                _broadcast(0x3c6ef372ul), _broadcast(0xa54ff53aul),
+                _broadcast(0x510e527ful), _broadcast(0x9b05688cul),
+                _broadcast(0x1f83d9abul), _broadcast(0x5be0cd19ul),
+            };
+            _outer_block(state, a, b, c, d, e, f, g, h);
+
+            uint8_t digest[32 * Instr::way()];
+            _save_state(digest, state, _transpose_tag<8>());
+            for (int i = 0; i < Instr::way(); i++) {
+                if (!((mask >> i) & 1)) continue;
+                if (_le256_less_equal(digest + i * 32, target_le)) {
+                    if (hits < max_found) found[hits] = nonce_start + (uint32_t)(done + i);
+                    hits++;
+                }
+            }
+        }
+        return hits;
     }
 };
 
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <fingera/span.hpp>
+
+namespace fingera {
+namespace hash {
+
+// sha256 of every message (messages[n], lengths[n] bytes) on the best multiway
+// backend, out[32 * n .. 32 * n + 31] gets its digest. Lengths may differ,
+// a lane takes the next message as soon as its current one is done.
+// throws std::range_error when the spans do not match.
+void sha256_many(span<const void *const> messages, span<const size_t> lengths, span<uint8_t> out);
+
+} // namespace hash
+} // namespace fingera
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <fingera/config.hpp>
+
+#if defined(FINGERA_USE_SHA)
+
+#include <cstdint>
+#include <immintrin.h>
+
+// CPUID: SHA SSE4.1
+// single buffer sha256, sha256rnds2 / sha256msg1 / sha256msg2
+namespace fingera {
+namespace hash {
+
+class sha256_shani {
+public:
+    using type = uint32_t;
+
+    static FINGERA_FORCEINLINE constexpr int way() {
+        return 1;
+    }
+protected:
+    static FINGERA_FORCEINLINE __m128i _k(int i) {
+        alignas(16) static const uint32_t K[64] = {
+            0x428a2f98ul, 0x71374491ul, 0xb5c0fbcful, 0xe9b5dba5ul, 0x3956c25bul, 0x59f111f1ul, 0x923f82a4ul, 0xab1c5ed5ul,
+            0xd807aa98ul, 0x12835b01ul, 0x243185beul, 0x550c7dc3ul, 0x72be5d74ul, 0x80deb1feul, 0x9bdc06a7ul, 0xc19bf174ul,
+            0xe49b69c1ul, 0xefbe4786ul, 0x0fc19dc6ul, 0x240ca1ccul, 0x2de92c6ful, 0x4a7484aaul, 0x5cb0a9dcul, 0x76f988daul,
+            0x983e5152ul, 0xa831c66dul, 0xb00327c8ul, 0xbf597fc7ul, 0xc6e00bf3ul, 0xd5a79147ul, 0x06ca6351ul, 0x14292967ul,
+            0x27b70a85ul, 0x2e1b2138ul, 0x4d2c6dfcul, 0x53380d13ul, 0x650a7354ul, 0x766a0abbul, 0x81c2c92eul, 0x92722c85ul,
+            0xa2bfe8a1ul, 0xa81a664bul, 0xc24b8b70ul, 0xc76c51a3ul, 0xd192e819ul, 0xd6990624ul, 0xf40e3585ul, 0x106aa070ul,
+            0x19a4c116ul, 0x1e376c08ul, 0x2748774cul, 0x34b0bcb5ul, 0x391c0cb3ul, 0x4ed8aa4aul, 0x5b9cca4ful, 0x682e6ff3ul,
+            0x748f82eeul, 0x78a5636ful, 0x84c87814ul, 0x8cc70208ul, 0x90befffaul, 0xa4506cebul, 0xbef9a3f7ul, 0xc67178f2ul,
+        };
+        return _mm_load_si128(reinterpret_cast<const __m128i *>(K + i));
+    }
+    static FINGERA_FORCEINLINE __m128i _load(const void *block, int offset) {
+        const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+        return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(static_cast<const char *>(block) + offset)), mask);
+    }
+    // four rounds with w[i .. i + 3] = m
+    static FINGERA_FORCEINLINE void quad_round(__m128i &abef, __m128i &cdgh, __m128i m, int i) {
+        __m128i msg = _mm_add_epi32(m, _k(i));
+        cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);
+        abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(msg, 0x0e));
+    }
+public:
+    // abef = { f, e, b, a } cdgh = { h, g, d, c } (lane 0 first)
+    static FINGERA_FORCEINLINE void process_block(__m128i &abef, __m128i &cdgh, const void *block) {
+        __m128i oabef = abef;
+        __m128i ocdgh = cdgh;
+
+        __m128i m0 = _load(block, 0);
+        __m128i m1 = _load(block, 16);
+        __m128i m2 = _load(block, 32);
+        __m128i m3 = _load(block, 48);
+
+        quad_round(abef, cdgh, m0, 0);
+        quad_round(abef, cdgh, m1, 4);
+        m0 = _mm_sha256msg1_epu32(m0, m1);
+        quad_round(abef, cdgh, m2, 8);
+        m1 = _mm_sha256msg1_epu32(m1, m2);
+        quad_round(abef, cdgh, m3, 12);
+
+        // w[j] = msg2(msg1(w[j - 4], w[j - 3]) + alignr(w[j - 1], w[j - 2]), w[j - 1]), 4 words each
+        // msg1 of w[j - 2] waits until alignr no longer needs it
+        for (int i = 16; i < 64; i += 16) {
+            m0 = _mm_sha256msg2_epu32(_mm_add_epi32(m0, _mm_alignr_epi8(m3, m2, 4)), m3);
+            quad_round(abef, cdgh, m0, i);
+            m2 = _mm_sha256msg1_epu32(m2, m3);
+            m1 = _mm_sha256msg2_epu32(_mm_add_epi32(m1, _mm_alignr_epi8(m0, m3, 4)), m0);
+            quad_round(abef, cdgh, m1, i + 4);
+            m3 = _mm_sha256msg1_epu32(m3, m0);
+            m2 = _mm_sha256msg2_epu32(_mm_add_epi32(m2, _mm_alignr_epi8(m1, m0, 4)), m1);
+            quad_round(abef, cdgh, m2, i + 8);
+            m0 = _mm_sha256msg1_epu32(m0, m1);
+            m3 = _mm_sha256msg2_epu32(_mm_add_epi32(m3, _mm_alignr_epi8(m2, m1, 4)), m2);
+            quad_round(abef, cdgh, m3, i + 12);
+            m1 = _mm_sha256msg1_epu32(m1, m2);
+        }
+
+        abef = _mm_add_epi32(abef, oabef);
+        cdgh = _mm_add_epi32(cdgh, ocdgh);
+    }
+
+    static FINGERA_FORCEINLINE void process_block(
+            type &a, type &b, type &c, type &d,
+            type &e, type &f, type &g, type &h,
+            const void *block) {
+        __m128i abef = _mm_set_epi32(a, b, e, f);
+        __m128i cdgh = _mm_set_epi32(c, d, g, h);
+        process_block(abef, cdgh, block);
+        a = _mm_extract_epi32(abef, 3);
+        b = _mm_extract_epi32(abef, 2);
+        e = _mm_extract_epi32(abef, 1);
+        f = _mm_extract_epi32(abef, 0);
+        c = _mm_extract_epi32(cdgh, 3);
+        d = _mm_extract_epi32(cdgh, 2);
+        g = _mm_extract_epi32(cdgh, 1);
+        h = _mm_extract_epi32(cdgh, 0);
+    }
+
+    static FINGERA_NOINLINE void process_trunk(void *out, const void *blocks, int count = 1) {
+        __m128i abef = _mm_set_epi32(0x6a09e667ul, 0xbb67ae85ul, 0x510e527ful, 0x9b05688cul);
+        __m128i cdgh = _mm_set_epi32(0x3c6ef372ul, 0xa54ff53aul, 0x1f83d9abul, 0x5be0cd19ul);
+
+        const char *cur_block = static_cast<const char *>(blocks);
+        while (count--) {
+            process_block(abef, cdgh, cur_block);
+            cur_block += 64;
+        }
+
+        // { f, e, b, a } { h, g, d, c } => big endian a b c d e f g h
+        const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bull, 0x0405060700010203ull);
+        __m128i abcd = _mm_shuffle_epi8(_mm_unpackhi_epi64(cdgh, abef), mask);
+        __m128i efgh = _mm_shuffle_epi8(_mm_unpacklo_epi64(cdgh, abef), mask);
+        abcd = _mm_shuffle_epi32(abcd, 0x1b);
+        efgh = _mm_shuffle_epi32(efgh, 0x1b);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(static_cast<char *>(out) + 0), abcd);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(static_cast<char *>(out) + 16), efgh);
+    }
+};
+
+} // namespace hash
+} // namespace fingera
+
+#endif // FINGERA_USE_SHA
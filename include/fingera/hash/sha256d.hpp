@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <fingera/span.hpp>
+
+namespace fingera {
+namespace hash {
+
+// sha256d(header80) for every nonce in nonce_start .. nonce_start + count - 1
+// (little endian at offset 76) on the best multiway backend.
+// target is a 32 bytes little endian uint256, returns the nonces with hash <= target.
+std::vector<uint32_t> scan_nonces(const void *header80, uint32_t nonce_start, uint64_t count, const void *target);
+
+// Bitcoin style Merkle root of leaves.size() / 32 hashes (internal byte order),
+// every level is hashed pairwise with sha256d on the best multiway backend, an
+// odd level repeats its last hash. Levels of at least 1024 pairs per thread are
+// split over up to threads threads. No leaves gives a zero root.
+// throws std::range_error when leaves is not a multiple of 32 bytes.
+void merkle_root(span<const uint8_t> leaves, void *root, unsigned threads = 1);
+
+} // namespace hash
+} // namespace fingera
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fingera {
+
+// Large, randomly accessed memory (CryptoNight scratchpads). Tried in order:
+// explicit hugepages (1GB pages when the size is a multiple of 1GB, then 2MB
+// pages, both need pages reserved in /proc/sys/vm/nr_hugepages), transparent
+// hugepages requested with madvise, plain pages. Always 2MB aligned.
+// A node >= 0 makes that NUMA node the preferred one for its pages (linux,
+// mbind without libnuma): they still come from another node when it is
+// full, rather than failing on first touch.
+class hugepage_buffer {
+public:
+    enum kind_t {
+        none,           // empty buffer
+        hugetlb,        // explicit hugepages
+        transparent,    // madvise(MADV_HUGEPAGE), the kernel may still use 4K pages
+        normal,
+    };
+
+    hugepage_buffer() = default;
+    explicit hugepage_buffer(size_t size, int node = -1);
+    ~hugepage_buffer();
+
+    hugepage_buffer(hugepage_buffer &&other);
+    hugepage_buffer &operator=(hugepage_buffer &&other);
+    hugepage_buffer(const hugepage_buffer &) = delete;
+    hugepage_buffer &operator=(const hugepage_buffer &) = delete;
+
+    uint8_t *data() const { return _data; }
+    size_t size() const { return _size; }
+    kind_t kind() const { return _kind; }
+    // NUMA node holding the first page, -1 when unknown. Touch it first:
+    // an untouched page is faulted in as by a read.
+    int resident_node() const;
+protected:
+    uint8_t *_data = nullptr;
+    size_t _size = 0;
+    size_t _mapped = 0;     // rounded up to the page size actually used
+    kind_t _kind = none;
+
+    void _release();
+};
+
+// hugepage_buffer allocations since start, by the kind they got
+struct hugepage_counters {
+    uint64_t hugetlb;
+    uint64_t transparent;
+    uint64_t normal;
+};
+hugepage_counters get_hugepage_counters();
+
+} // namespace fingera
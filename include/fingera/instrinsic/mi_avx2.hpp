@@ -109,6 +109,74 @@ public:
             write_big<uint32_t>(ptr + blk_size * 7, _mm256_extract_epi32(value, 0));
         }
     }
+
+    // in-place 8x8 transpose of 32 bits words, r[i] element j <=> r[j] element i
+    static FINGERA_FORCEINLINE void transpose(impl_type *r) {
+        impl_type t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+        impl_type t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+        impl_type t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+        impl_type t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+        impl_type t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+        impl_type t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+        impl_type t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+        impl_type t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+        impl_type u0 = _mm256_unpacklo_epi64(t0, t2);
+        impl_type u1 = _mm256_unpackhi_epi64(t0, t2);
+        impl_type u2 = _mm256_unpacklo_epi64(t1, t3);
+        impl_type u3 = _mm256_unpackhi_epi64(t1, t3);
+        impl_type u4 = _mm256_unpacklo_epi64(t4, t6);
+        impl_type u5 = _mm256_unpackhi_epi64(t4, t6);
+        impl_type u6 = _mm256_unpacklo_epi64(t5, t7);
+        impl_type u7 = _mm256_unpackhi_epi64(t5, t7);
+        r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+        r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+        r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+        r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+        r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+        r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+        r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+        r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+    }
+    static FINGERA_FORCEINLINE impl_type bswap(impl_type x) {
+        const impl_type mask = _mm256_set_epi8(
+            12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+            12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        return _mm256_shuffle_epi8(x, mask);
+    }
+
+    // out[j] = load<ReadLittleEndian>(mem, blk_size, offset + 4 * j), j = 0 .. 7
+    // one 32 bytes load per block instead of 64 scalar reads
+    template<bool ReadLittleEndian = true>
+    static FINGERA_FORCEINLINE void load_transpose(const void *mem, size_t blk_size, size_t offset, impl_type *out) {
+        const char *ptr = static_cast<const char *>(mem) + offset;
+        for (int i = 0; i < 8; i++) {
+            out[i] = _mm256_loadu_si256((const __m256i *)(ptr + blk_size * (7 - i)));
+            if (!ReadLittleEndian) out[i] = bswap(out[i]);
+        }
+        transpose(out);
+    }
+    // save<WriteLittleEndian>(in[j], out, blk_size, offset + 4 * j), j = 0 .. 7
+    template<bool WriteLittleEndian = true>
+    static FINGERA_FORCEINLINE void save_transpose(const impl_type *in, void *out, size_t blk_size, size_t offset) {
+        char *ptr = static_cast<char *>(out) + offset;
+        impl_type r[8];
+        for (int i = 0; i < 8; i++) {
+            r[i] = in[i];
+        }
+        transpose(r);
+        for (int i = 0; i < 8; i++) {
+            if (!WriteLittleEndian) r[i] = bswap(r[i]);
+            _mm256_storeu_si256((__m256i *)(ptr + blk_size * (7 - i)), r[i]);
+        }
+    }
+
+    // lane-major layout: little endian words of lane 0 .. 7 side by side
+    static FINGERA_FORCEINLINE impl_type load_lanes(const void *mem) {
+        return _mm256_loadu_si256((const __m256i *)mem);
+    }
+    static FINGERA_FORCEINLINE void save_lanes(impl_type value, void *out) {
+        _mm256_storeu_si256((__m256i *)out, value);
+    }
 };
 
 } // namespace instrinsic
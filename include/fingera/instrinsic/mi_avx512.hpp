@@ -0,0 +1,138 @@
+#pragma once
+
+#include <fingera/config.hpp>
+
+#if defined(FINGERA_USE_AVX512F)
+
+#include <cstdint>
+#include <functional>
+#include <immintrin.h>
+#include <fingera/endian.hpp>
+
+// CPUID: AVX512F
+// FOR: SHA2(256) RIPEMD160
+// mm512 => uint32_t
+namespace fingera {
+namespace instrinsic {
+
+class mi_avx512 {
+public:
+    using type = __m512i;
+    using impl_type = __m512i;
+    using target_type = uint32_t;
+
+    static FINGERA_FORCEINLINE constexpr int way() {
+        return sizeof(impl_type) / sizeof(target_type);
+    }
+
+    static FINGERA_FORCEINLINE impl_type op_broadcast(target_type value) {
+        return _mm512_set1_epi32(value);
+    }
+
+    static FINGERA_FORCEINLINE impl_type op_add(impl_type x, impl_type y) {
+        return _mm512_add_epi32(x, y);
+    }
+
+    static FINGERA_FORCEINLINE impl_type op_xor(impl_type x, impl_type y) {
+        return _mm512_xor_si512(x, y);
+    }
+    static FINGERA_FORCEINLINE impl_type op_or(impl_type x, impl_type y) {
+        return _mm512_or_si512(x, y);
+    }
+    static FINGERA_FORCEINLINE impl_type op_and(impl_type x, impl_type y) {
+        return _mm512_and_si512(x, y);
+    }
+    static FINGERA_FORCEINLINE impl_type op_andnot(impl_type x, impl_type y) {
+        return _mm512_andnot_si512(x, y);
+    }
+    // vpternlogd: Imm is the truth table of f(x, y, z), x = 0xF0 y = 0xCC z = 0xAA
+    template<int Imm>
+    static FINGERA_FORCEINLINE impl_type op_ternary(impl_type x, impl_type y, impl_type z) {
+        return _mm512_ternarylogic_epi32(x, y, z, Imm);
+    }
+
+    template<int N>
+    static FINGERA_FORCEINLINE impl_type op_shr(impl_type x) {
+        return _mm512_srli_epi32(x, N);
+    }
+    template<int N>
+    static FINGERA_FORCEINLINE impl_type op_shl(impl_type x) {
+        return _mm512_slli_epi32(x, N);
+    }
+    template<int N>
+    static FINGERA_FORCEINLINE impl_type op_rol(impl_type x) {
+        return _mm512_rol_epi32(x, N);
+    }
+
+    template<bool ReadLittleEndian = true>
+    static FINGERA_FORCEINLINE impl_type load(const void *mem, size_t blk_size, size_t offset) {
+        const char *ptr = static_cast<const char *>(mem) + offset;
+        if (ReadLittleEndian) {
+            return _mm512_set_epi32(
+                read_little<uint32_t>(ptr + blk_size * 0),
+                read_little<uint32_t>(ptr + blk_size * 1),
+                read_little<uint32_t>(ptr + blk_size * 2),
+                read_little<uint32_t>(ptr + blk_size * 3),
+                read_little<uint32_t>(ptr + blk_size * 4),
+                read_little<uint32_t>(ptr + blk_size * 5),
+                read_little<uint32_t>(ptr + blk_size * 6),
+                read_little<uint32_t>(ptr + blk_size * 7),
+                read_little<uint32_t>(ptr + blk_size * 8),
+                read_little<uint32_t>(ptr + blk_size * 9),
+                read_little<uint32_t>(ptr + blk_size * 10),
+                read_little<uint32_t>(ptr + blk_size * 11),
+                read_little<uint32_t>(ptr + blk_size * 12),
+                read_little<uint32_t>(ptr + blk_size * 13),
+                read_little<uint32_t>(ptr + blk_size * 14),
+                read_little<uint32_t>(ptr + blk_size * 15)
+            );
+        }
+        return _mm512_set_epi32(
+            read_big<uint32_t>(ptr + blk_size * 0),
+            read_big<uint32_t>(ptr + blk_size * 1),
+            read_big<uint32_t>(ptr + blk_size * 2),
+            read_big<uint32_t>(ptr + blk_size * 3),
+            read_big<uint32_t>(ptr + blk_size * 4),
+            read_big<uint32_t>(ptr + blk_size * 5),
+            read_big<uint32_t>(ptr + blk_size * 6),
+            read_big<uint32_t>(ptr + blk_size * 7),
+            read_big<uint32_t>(ptr + blk_size * 8),
+            read_big<uint32_t>(ptr + blk_size * 9),
+            read_big<uint32_t>(ptr + blk_size * 10),
+            read_big<uint32_t>(ptr + blk_size * 11),
+            read_big<uint32_t>(ptr + blk_size * 12),
+            read_big<uint32_t>(ptr + blk_size * 13),
+            read_big<uint32_t>(ptr + blk_size * 14),
+            read_big<uint32_t>(ptr + blk_size * 15)
+        );
+    }
+    template<bool WriteLittleEndian = true>
+    static FINGERA_FORCEINLINE void save(impl_type value, void *out, size_t blk_size, size_t offset) {
+        union {
+            __m512i mm;
+            uint32_t data[16];
+        };
+        _mm512_storeu_si512(&mm, value);
+        char *ptr = static_cast<char *>(out) + offset;
+        for (int i = 0; i < 16; i++) {
+            if (WriteLittleEndian) {
+                write_little(ptr + blk_size * i, data[15 - i]);
+            } else {
+                write_big(ptr + blk_size * i, data[15 - i]);
+            }
+        }
+    }
+
+    // lane-major layout: little endian words of lane 0 .. 15 side by side
+    static FINGERA_FORCEINLINE impl_type load_lanes(const void *mem) {
+        return _mm512_loadu_si512(mem);
+    }
+    static FINGERA_FORCEINLINE void save_lanes(impl_type value, void *out) {
+        _mm512_storeu_si512(out, value);
+    }
+};
+
+} // namespace instrinsic
+} // namespace fingera
+
+#endif // FINGERA_USE_AVX512F
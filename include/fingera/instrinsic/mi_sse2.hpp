@@ -93,6 +93,56 @@ public:
             }
         }
     }
+
+    // in-place 4x4 transpose of 32 bits words, r[i] element j <=> r[j] element i
+    static FINGERA_FORCEINLINE void transpose(impl_type *r) {
+        impl_type t0 = _mm_unpacklo_epi32(r[0], r[1]);
+        impl_type t1 = _mm_unpackhi_epi32(r[0], r[1]);
+        impl_type t2 = _mm_unpacklo_epi32(r[2], r[3]);
+        impl_type t3 = _mm_unpackhi_epi32(r[2], r[3]);
+        r[0] = _mm_unpacklo_epi64(t0, t2);
+        r[1] = _mm_unpackhi_epi64(t0, t2);
+        r[2] = _mm_unpacklo_epi64(t1, t3);
+        r[3] = _mm_unpackhi_epi64(t1, t3);
+    }
+    // no pshufb before ssse3: swap the 16 bits halves, then the bytes
+    static FINGERA_FORCEINLINE impl_type bswap(impl_type x) {
+        x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xb1), 0xb1);
+        return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    }
+
+    // out[j] = load<ReadLittleEndian>(mem, blk_size, offset + 4 * j), j = 0 .. 3
+    template<bool ReadLittleEndian = true>
+    static FINGERA_FORCEINLINE void load_transpose(const void *mem, size_t blk_size, size_t offset, impl_type *out) {
+        const char *ptr = static_cast<const char *>(mem) + offset;
+        for (int i = 0; i < 4; i++) {
+            out[i] = _mm_loadu_si128((const __m128i *)(ptr + blk_size * (3 - i)));
+            if (!ReadLittleEndian) out[i] = bswap(out[i]);
+        }
+        transpose(out);
+    }
+    // save<WriteLittleEndian>(in[j], out, blk_size, offset + 4 * j), j = 0 .. 3
+    template<bool WriteLittleEndian = true>
+    static FINGERA_FORCEINLINE void save_transpose(const impl_type *in, void *out, size_t blk_size, size_t offset) {
+        char *ptr = static_cast<char *>(out) + offset;
+        impl_type r[4];
+        for (int i = 0; i < 4; i++) {
+            r[i] = in[i];
+        }
+        transpose(r);
+        for (int i = 0; i < 4; i++) {
+            if (!WriteLittleEndian) r[i] = bswap(r[i]);
+            _mm_storeu_si128((__m128i *)(ptr + blk_size * (3 - i)), r[i]);
+        }
+    }
+
+    // lane-major layout: little endian words of lane 0 .. 3 side by side
+    static FINGERA_FORCEINLINE impl_type load_lanes(const void *mem) {
+        return _mm_loadu_si128((const __m128i *)mem);
+    }
+    static FINGERA_FORCEINLINE void save_lanes(impl_type value, void *out) {
+        _mm_storeu_si128((__m128i *)out, value);
+    }
 };
 
 } // namespace instrinsic
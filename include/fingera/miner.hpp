@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fingera/cpu_features.hpp>
+
+namespace fingera {
+
+class hugepage_buffer;
+
+// A CryptoNight job as a pool sends it, see hash::cryptonight_scan
+struct miner_job {
+    std::string id;
+    std::string algorithm = "cn/1";     // hash::cryptonight names
+    std::vector<uint8_t> blob;          // nonce at offset 39
+    uint64_t target64 = 0;              // shares: top 64 bits of the hash below it
+    uint64_t nonce_begin = 0;           // nonces handed out, nonce_end at most 2^32
+    uint64_t nonce_end = (uint64_t)1 << 32;
+};
+
+struct miner_share {
+    std::string job_id;
+    uint32_t nonce;
+    uint8_t result[32];
+};
+
+struct miner_options {
+    size_t threads = 0;         // 0: miner::default_threads of each job
+    int ways = 1;               // nonces per kernel call, 1 .. 5
+    uint32_t batch = 16;        // nonces per worker between job checks
+    bool affinity = true;       // pin workers, see miner
+};
+
+// Per worker, refreshed about once a second by the worker itself
+struct miner_worker_stats {
+    int cpu;                    // pinned to, -1 when not pinned
+    int node;                   // NUMA node of cpu, -1 when unknown
+    int memory_node;            // NUMA node holding the scratchpad, -1 when unknown
+    uint64_t hashes;            // since start
+    double hashrate;            // hashes per second over the last window
+};
+
+// Workers summed by the NUMA node of their cpu
+struct miner_node_stats {
+    int node;                   // -1: workers not pinned or nodes unknown
+    size_t workers;
+    size_t misplaced;           // scratchpad on another node
+    double hashrate;
+};
+
+// CryptoNight mining threads sharing a job. Worker i of the n mining it
+// scans the batches nonce_begin + (k * n + i) * batch, each with its own
+// scratchpad allocated on its own thread after pinning. Without a thread
+// count there is one worker per allowed cpu and n follows each job's
+// algorithm (default_threads), the others idle. A new job is picked up
+// after the batch in flight. With affinity workers are pinned one per core first, taking
+// cores round robin over the last level caches, performance cores before
+// efficiency ones, then to the SMT siblings; scratchpads then prefer the
+// NUMA node of their worker. on_share runs on the worker threads and must
+// not throw.
+class miner {
+public:
+    using share_handler = std::function<void(const miner_share &share)>;
+
+    explicit miner(share_handler on_share, const miner_options &options = miner_options());
+    ~miner();
+
+    miner(const miner &) = delete;
+    miner &operator=(const miner &) = delete;
+
+    // replaces the current job, throws std::invalid_argument for an unknown
+    // algorithm, a blob shorter than 43 bytes or an empty nonce range
+    void set_job(const miner_job &job);
+    // workers idle until the next set_job
+    void pause();
+    // joins the workers, also done by the destructor
+    void stop();
+
+    size_t threads() const { return _workers.size(); }
+    // workers mining the current job, 0 while paused
+    size_t active_threads() const;
+    std::vector<miner_worker_stats> stats() const;
+    std::vector<miner_node_stats> node_stats() const;    // by node
+    double hashrate() const;
+
+    // last level caches / (scratchpad * ways) of algorithm, at most one per
+    // allowed cpu, one per allowed cpu when the cache size is unknown
+    static size_t default_threads(const char *algorithm, int ways = 1);
+protected:
+    struct worker {
+        std::thread thread;
+        std::atomic<int> cpu{-1};
+        std::atomic<int> node{-1};
+        std::atomic<int> memory_node{-1};
+        std::atomic<uint64_t> hashes{0};
+        std::atomic<double> hashrate{0};
+        // hashrate window, worker thread only
+        std::chrono::steady_clock::time_point window;
+        uint64_t window_hashes = 0;
+    };
+
+    share_handler _on_share;
+    miner_options _options;
+    cpu_topology _topology;
+    std::vector<std::unique_ptr<worker>> _workers;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wake;
+    std::shared_ptr<const miner_job> _job;     // nullptr while paused
+    size_t _active = 0;                         // workers mining _job
+    std::atomic<uint64_t> _sequence{0};         // bumped by set_job and pause
+    std::atomic<bool> _stopping{false};
+
+    void _run(size_t index);
+    void _mine(size_t index, size_t active, const miner_job &job, uint64_t sequence, hugepage_buffer &scratchpad);
+};
+
+} // namespace fingera
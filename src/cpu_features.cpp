@@ -1,5 +1,18 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <thread>
+#include <tuple>
 #include <fingera/cpu_features.hpp>
+#if defined(_WIN32)
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
 
 namespace fingera {
 
@@ -101,13 +114,12 @@ static bool x86_xgetbv(unsigned *ax, unsigned *dx) {
 #endif
 }
 
-bool get_cpu_features(std::unordered_map<std::string, bool> &features) {
-    unsigned ax = 0, bx = 0, cx = 0, dx = 0;
-    unsigned max_level;
-    if (!x86_cpuid(0, &max_level, &bx, &cx, &dx) || max_level < 1) {
+bool decode_cpu_features(const cpuid_leaves &leaves, std::unordered_map<std::string, bool> &features) {
+    const unsigned max_level = leaves.max_level;
+    if (max_level < 1) {
         return false;
     }
-    x86_cpuid(1, &ax, &bx, &cx, &dx);
+    unsigned ax = 0, bx = 0, cx = leaves.leaf1_cx, dx = leaves.leaf1_dx;
 
     features["cmov"] = (dx >> 15) & 1;
     features["mmx"] = (dx >> 23) & 1;
@@ -128,8 +140,8 @@ bool get_cpu_features(std::unordered_map<std::string, bool> &features) {
     // If CPUID indicates support for XSAVE, XRESTORE and AVX, and XGETBV
     // indicates that the AVX registers will be saved and restored on context
     // switch, then we have full AVX support.
-    bool has_avx_save = ((cx >> 27) & 1) && ((cx >> 28) & 1) &&
-                    x86_xgetbv(&ax, &dx) && ((ax & 0x6) == 0x6);
+    ax = leaves.xcr0;
+    bool has_avx_save = ((cx >> 27) & 1) && ((cx >> 28) & 1) && ((ax & 0x6) == 0x6);
     features["avx"] = has_avx_save;
     features["fma"] = has_avx_save && (cx >> 12) & 1;
     features["f16c"] = has_avx_save && (cx >> 29) & 1;
@@ -140,10 +152,8 @@ bool get_cpu_features(std::unordered_map<std::string, bool> &features) {
     // AVX512 requires additional context to be saved by the OS.
     bool has_avx512_save = has_avx_save && ((ax & 0xe0) == 0xe0);
 
-    unsigned max_ext_level;
-    x86_cpuid(0x80000000, &max_ext_level, &bx, &cx, &dx);
-
-    bool hax_ext_leaf1 = max_ext_level >= 0x80000001 && x86_cpuid(0x80000001, &ax, &bx, &cx, &dx);
+    bool hax_ext_leaf1 = leaves.max_ext_level >= 0x80000001;
+    cx = leaves.ext1_cx;
     features["lzcnt"] = hax_ext_leaf1 && ((cx >> 5) & 1);
     features["sse4a"] = hax_ext_leaf1 && ((cx >> 6) & 1);
     features["prfchw"] = hax_ext_leaf1 && ((cx >> 8) & 1);
@@ -152,8 +162,9 @@ bool get_cpu_features(std::unordered_map<std::string, bool> &features) {
     features["tbm"] = hax_ext_leaf1 && ((cx >> 21) & 1);
     features["mwaitx"] = hax_ext_leaf1 && ((cx >> 29) & 1);
 
-    bool has_leaf7 =
-        max_level >= 7 && x86_cpuid_ex(0x7, 0x0, &ax, &bx, &cx, &dx);
+    bool has_leaf7 = max_level >= 7;
+    bx = leaves.leaf7_bx;
+    cx = leaves.leaf7_cx;
 
     // AVX2 is only supported if we have the OS save support from AVX.
     features["avx2"] = has_avx_save && has_leaf7 && ((bx >> 5) & 1);
@@ -187,9 +198,13 @@ bool get_cpu_features(std::unordered_map<std::string, bool> &features) {
     features["avx512vbmi"] = has_leaf7 && ((cx >> 1) & 1) && has_avx512_save;
     // Enable protection keys
     features["pku"] = has_leaf7 && ((cx >> 4) & 1);
+    // 256 bit AES instructions need the YMM state, 512 bit ones avx512f too.
+    // The vaes backend mixes them with AVX2 integer code, so a cpu (or a
+    // hypervisor) reporting VAES without AVX2 doesn't count.
+    features["vaes"] = has_leaf7 && ((cx >> 9) & 1) && has_avx_save && features["avx2"];
 
-    bool has_leafd = max_level >= 0xd &&
-                    x86_cpuid_ex(0xd, 0x1, &ax, &bx, &cx, &dx);
+    bool has_leafd = max_level >= 0xd;
+    ax = leaves.leafd1_ax;
 
     // Only enable XSAVE if OS has enabled support for saving YMM state.
     features["xsaveopt"] = has_avx_save && has_leafd && ((ax >> 0) & 1);
@@ -199,6 +214,344 @@ bool get_cpu_features(std::unordered_map<std::string, bool> &features) {
     return true;
 }
 
+bool get_cpu_features(std::unordered_map<std::string, bool> &features) {
+    unsigned ax = 0, bx = 0, cx = 0, dx = 0;
+    cpuid_leaves leaves = {};
+    if (!x86_cpuid(0, &leaves.max_level, &bx, &cx, &dx) || leaves.max_level < 1) {
+        return false;
+    }
+    x86_cpuid(1, &ax, &bx, &leaves.leaf1_cx, &leaves.leaf1_dx);
+    // XGETBV faults unless the OS enabled it (OSXSAVE)
+    if (((leaves.leaf1_cx >> 27) & 1) && !x86_xgetbv(&leaves.xcr0, &dx)) {
+        leaves.xcr0 = 0;
+    }
+    x86_cpuid(0x80000000, &leaves.max_ext_level, &bx, &cx, &dx);
+    if (leaves.max_ext_level >= 0x80000001) {
+        x86_cpuid(0x80000001, &ax, &bx, &leaves.ext1_cx, &dx);
+    }
+    if (leaves.max_level >= 7) {
+        x86_cpuid_ex(0x7, 0x0, &ax, &leaves.leaf7_bx, &leaves.leaf7_cx, &dx);
+    }
+    if (leaves.max_level >= 0xd) {
+        x86_cpuid_ex(0xd, 0x1, &leaves.leafd1_ax, &bx, &cx, &dx);
+    }
+    return decode_cpu_features(leaves, features);
+}
+
+// DetectCPUFeatures.cmake builds the feature list alone, without pthread
+#if !defined(CPU_FEATURES_BUILD_MAIN)
+
+int cpu_topology::node_of(int cpu) const {
+    for (const cpu_node &node : nodes) {
+        if (std::binary_search(node.cpus.begin(), node.cpus.end(), cpu)) return node.id;
+    }
+    return -1;
+}
+
+int cpu_topology::last_level() const {
+    int level = 0;
+    for (const cpu_cache &cache : caches) level = std::max(level, cache.level);
+    return level;
+}
+
+size_t cpu_topology::cache_size(int level) const {
+    for (const cpu_cache &cache : caches) {
+        if (cache.level == level && cache.type != cpu_cache::instruction) return cache.size;
+    }
+    return 0;
+}
+
+size_t cpu_topology::total_cache_size(int level) const {
+    size_t total = 0;
+    for (const cpu_cache &cache : caches) {
+        if (cache.level == level && cache.type != cpu_cache::instruction) total += cache.size;
+    }
+    return total;
+}
+
+// What one logical cpu reports, ids only compare within one source
+struct cpu_record {
+    struct cache {
+        int level;
+        cpu_cache::type_t type;
+        size_t size;
+        size_t line_size;
+        uint64_t id;
+    };
+
+    int cpu;
+    uint64_t core;
+    int package;
+    cpu_core::type_t type;
+    std::vector<cache> caches;
+};
+
+static std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+#elif defined(_WIN32)
+    DWORD_PTR process, system;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+        for (int cpu = 0; cpu < (int)sizeof(process) * 8; cpu++) {
+            if ((process >> cpu) & 1) cpus.push_back(cpu);
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        const int n = std::max(1u, std::thread::hardware_concurrency());
+        for (int cpu = 0; cpu < n; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// runs fn on a thread pinned to cpu, false when it can't be pinned
+static bool run_on_cpu(int cpu, const std::function<void()> &fn) {
+    bool pinned = false;
+    std::thread([&] {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+        pinned = cpu < 64 && SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#endif
+        if (pinned) fn();
+    }).join();
+    return pinned;
+}
+
+static unsigned ceil_log2(unsigned x) {
+    unsigned shift = 0;
+    while ((1u << shift) < x) shift++;
+    return shift;
+}
+
+// on the cpu it describes: APIC ids shifted right by a level's width name
+// that level's instance
+static void cpuid_record(cpu_record &record) {
+    unsigned ax = 0, bx = 0, cx = 0, dx = 0;
+    unsigned max_level, max_ext_level, vendor;
+    x86_cpuid(0, &max_level, &vendor, &cx, &dx);
+    x86_cpuid(0x80000000, &max_ext_level, &bx, &cx, &dx);
+    x86_cpuid(1, &ax, &bx, &cx, &dx);
+    uint64_t apic = bx >> 24;
+    unsigned smt_shift = 0, package_shift = 0;
+
+    // 0x1F adds module and die levels to 0xB, both end with the package
+    unsigned leaf = 0;
+    if (max_level >= 0x1f && x86_cpuid_ex(0x1f, 0, &ax, &bx, &cx, &dx) && bx) leaf = 0x1f;
+    else if (max_level >= 0xb && x86_cpuid_ex(0xb, 0, &ax, &bx, &cx, &dx) && bx) leaf = 0xb;
+    for (unsigned subleaf = 0; leaf && subleaf < 8; subleaf++) {
+        x86_cpuid_ex(leaf, subleaf, &ax, &bx, &cx, &dx);
+        const unsigned level_type = (cx >> 8) & 0xff;
+        if (!level_type) break;
+        apic = dx;
+        if (level_type == 1) smt_shift = ax & 0x1f;
+        package_shift = ax & 0x1f;
+    }
+    record.core = apic >> smt_shift;
+    record.package = package_shift ? (int)(apic >> package_shift) : 0;
+
+    record.type = cpu_core::unknown;
+    if (max_level >= 0x1a && x86_cpuid_ex(7, 0, &ax, &bx, &cx, &dx) && ((dx >> 15) & 1)) {
+        x86_cpuid_ex(0x1a, 0, &ax, &bx, &cx, &dx);
+        if ((ax >> 24) == 0x40) record.type = cpu_core::performance;
+        else if ((ax >> 24) == 0x20) record.type = cpu_core::efficiency;
+    }
+
+    // same layout in both leaves, AMD only has the second with TopologyExtensions
+    unsigned cache_leaf = 0;
+    if (vendor == 0x68747541) {     // "Auth"enticAMD
+        if (max_ext_level >= 0x8000001d && x86_cpuid(0x80000001, &ax, &bx, &cx, &dx) && ((cx >> 22) & 1)) {
+            cache_leaf = 0x8000001d;
+        }
+    } else if (max_level >= 4) {
+        cache_leaf = 4;
+    }
+    for (unsigned subleaf = 0; cache_leaf && subleaf < 16; subleaf++) {
+        x86_cpuid_ex(cache_leaf, subleaf, &ax, &bx, &cx, &dx);
+        const unsigned type = ax & 0x1f;
+        if (!type || type > 3) break;
+        cpu_record::cache cache;
+        cache.level = (ax >> 5) & 7;
+        cache.type = (cpu_cache::type_t)type;
+        cache.line_size = (bx & 0xfff) + 1;
+        cache.size = (size_t)((bx >> 22) + 1) * (((bx >> 12) & 0x3ff) + 1) * cache.line_size * ((size_t)cx + 1);
+        cache.id = apic >> ceil_log2(((ax >> 14) & 0xfff) + 1);
+        record.caches.push_back(cache);
+    }
+}
+
+static bool read_line(const std::string &path, std::string &line) {
+    std::ifstream file(path);
+    return (bool)std::getline(file, line);
+}
+
+// "0-3,8,10-11"
+static std::vector<int> parse_cpu_list(const std::string &list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        const std::string range = list.substr(pos, end - pos);
+        const size_t dash = range.find('-');
+        try {
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        } catch (const std::exception &) {
+            return {};
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+static bool sysfs_record(cpu_record &record) {
+#if defined(__linux__)
+    const std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(record.cpu) + "/";
+    std::string line;
+    if (!read_line(base + "topology/thread_siblings_list", line)) return false;
+    std::vector<int> siblings = parse_cpu_list(line);
+    if (siblings.empty()) return false;
+    record.core = siblings[0];
+    record.package = read_line(base + "topology/physical_package_id", line) ? std::atoi(line.c_str()) : 0;
+    record.type = cpu_core::unknown;
+
+    for (int index = 0; ; index++) {
+        const std::string dir = base + "cache/index" + std::to_string(index) + "/";
+        if (!read_line(dir + "level", line)) break;
+        cpu_record::cache cache;
+        cache.level = std::atoi(line.c_str());
+        if (!read_line(dir + "type", line)) return false;
+        if (line == "Data") cache.type = cpu_cache::data;
+        else if (line == "Instruction") cache.type = cpu_cache::instruction;
+        else cache.type = cpu_cache::unified;
+        if (!read_line(dir + "size", line)) return false;
+        cache.size = std::strtoull(line.c_str(), nullptr, 10);
+        if (line.back() == 'K') cache.size <<= 10;
+        else if (line.back() == 'M') cache.size <<= 20;
+        cache.line_size = read_line(dir + "coherency_line_size", line) ? std::atoi(line.c_str()) : 0;
+        if (!read_line(dir + "shared_cpu_list", line)) return false;
+        std::vector<int> shared = parse_cpu_list(line);
+        if (shared.empty()) return false;
+        cache.id = shared[0];
+        record.caches.push_back(cache);
+    }
+    return true;
+#else
+    (void)record;
+    return false;
+#endif
+}
+
+static void read_nodes(cpu_topology &topology) {
+#if defined(__linux__)
+    std::string line;
+    if (!read_line("/sys/devices/system/node/online", line)) return;
+    for (int id : parse_cpu_list(line)) {
+        if (!read_line("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist", line)) continue;
+        cpu_node node;
+        node.id = id;
+        for (int cpu : parse_cpu_list(line)) {
+            if (std::binary_search(topology.cpus.begin(), topology.cpus.end(), cpu)) node.cpus.push_back(cpu);
+        }
+        if (!node.cpus.empty()) topology.nodes.push_back(node);
+    }
+#else
+    (void)topology;
+#endif
+}
+
+static void assemble(const std::vector<cpu_record> &records, cpu_topology &topology) {
+    std::map<uint64_t, cpu_core> cores;
+    std::map<std::tuple<int, int, uint64_t>, cpu_cache> caches;
+    for (const cpu_record &record : records) {
+        cpu_core &core = cores[record.core];
+        core.type = record.type;
+        core.package = record.package;
+        core.cpus.push_back(record.cpu);
+        for (const cpu_record::cache &c : record.caches) {
+            cpu_cache &cache = caches[std::make_tuple(c.level, (int)c.type, c.id)];
+            cache.level = c.level;
+            cache.type = c.type;
+            cache.size = c.size;
+            cache.line_size = c.line_size;
+            cache.cpus.push_back(record.cpu);
+        }
+    }
+    topology.cores.clear();
+    for (auto &core : cores) topology.cores.push_back(core.second);
+    std::sort(topology.cores.begin(), topology.cores.end(), [](const cpu_core &a, const cpu_core &b) {
+        return a.cpus[0] < b.cpus[0];
+    });
+    topology.caches.clear();
+    for (auto &cache : caches) topology.caches.push_back(cache.second);
+    std::sort(topology.caches.begin(), topology.caches.end(), [](const cpu_cache &a, const cpu_cache &b) {
+        return std::make_tuple(a.level, a.type, a.cpus[0]) < std::make_tuple(b.level, b.type, b.cpus[0]);
+    });
+}
+
+static bool same_grouping(const cpu_topology &a, const cpu_topology &b) {
+    if (a.cores.size() != b.cores.size() || a.caches.size() != b.caches.size()) return false;
+    for (size_t i = 0; i < a.cores.size(); i++) {
+        if (a.cores[i].cpus != b.cores[i].cpus) return false;
+    }
+    for (size_t i = 0; i < a.caches.size(); i++) {
+        const cpu_cache &x = a.caches[i], &y = b.caches[i];
+        if (x.level != y.level || x.type != y.type || x.size != y.size || x.cpus != y.cpus) return false;
+    }
+    return true;
+}
+
+bool get_cpu_topology(cpu_topology &topology) {
+    topology = cpu_topology();
+    topology.cpus = allowed_cpus();
+    read_nodes(topology);
+
+    std::vector<cpu_record> cpuid_records, sysfs_records;
+    for (int cpu : topology.cpus) {
+        cpu_record record;
+        record.cpu = cpu;
+        if (!run_on_cpu(cpu, [&] { cpuid_record(record); })) break;
+        cpuid_records.push_back(record);
+        if (record.type != cpu_core::unknown) topology.hybrid = true;
+    }
+    if (cpuid_records.size() != topology.cpus.size()) cpuid_records.clear();
+    for (int cpu : topology.cpus) {
+        cpu_record record;
+        record.cpu = cpu;
+        if (!sysfs_record(record)) break;
+        if (!cpuid_records.empty()) record.type = cpuid_records[sysfs_records.size()].type;
+        sysfs_records.push_back(record);
+    }
+    if (sysfs_records.size() != topology.cpus.size()) sysfs_records.clear();
+    if (cpuid_records.empty() && sysfs_records.empty()) return false;
+
+    assemble(cpuid_records.empty() ? sysfs_records : cpuid_records, topology);
+    if (!cpuid_records.empty() && !sysfs_records.empty()) {
+        cpu_topology sysfs;
+        assemble(sysfs_records, sysfs);
+        if (!same_grouping(topology, sysfs)) {
+            topology.sysfs_mismatch = true;
+            topology.cores = std::move(sysfs.cores);
+            topology.caches = std::move(sysfs.caches);
+        }
+    }
+    return true;
+}
+
+#endif // !CPU_FEATURES_BUILD_MAIN
+
 } // namespace fingera
 
 #if defined(CPU_FEATURES_BUILD_MAIN)
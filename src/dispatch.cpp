@@ -0,0 +1,148 @@
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <fingera/cpu_features.hpp>
+#include <fingera/dispatch.hpp>
+#include "hash/backends.hpp"
+
+namespace fingera {
+namespace dispatch {
+
+static const std::unordered_map<std::string, bool> &cpu_features() {
+    static const std::unordered_map<std::string, bool> features = [] {
+        std::unordered_map<std::string, bool> r;
+        get_cpu_features(r);
+        return r;
+    }();
+    return features;
+}
+
+// feature: space separated keys, all of them required
+static bool is_supported(const char *feature) {
+    if (!feature) return true;
+    std::istringstream keys(feature);
+    std::string key;
+    while (keys >> key) {
+        auto it = cpu_features().find(key);
+        if (it == cpu_features().end() || !it->second) return false;
+    }
+    return true;
+}
+
+// candidates are listed fastest first
+template<typename Backend, size_t N>
+static std::vector<const Backend *> supported(const Backend *const (&candidates)[N]) {
+    std::vector<const Backend *> r;
+    for (size_t i = 0; i < N; i++) {
+        if (is_supported(candidates[i]->feature)) {
+            r.push_back(candidates[i]);
+        }
+    }
+    return r;
+}
+
+const std::vector<const sha256_backend *> &sha256_backends() {
+    static const sha256_backend *const candidates[] = {
+        &detail::sha256_avx512f,
+        &detail::sha256_avx2,
+        &detail::sha256_sse2,
+        &detail::sha256_generic,
+    };
+    static const std::vector<const sha256_backend *> backends = supported(candidates);
+    return backends;
+}
+
+const std::vector<const sha256_backend *> &sha256_single_backends() {
+    static const sha256_backend *const candidates[] = {
+        &detail::sha256_shani,
+        &detail::sha256_generic,
+    };
+    static const std::vector<const sha256_backend *> backends = supported(candidates);
+    return backends;
+}
+
+const std::vector<const monero_backend *> &monero_backends() {
+    static const monero_backend *const candidates[] = {
+        &detail::monero_vaes,
+        &detail::monero_aesni,
+        &detail::monero_softaes,
+        &detail::monero_portable,
+    };
+    static const std::vector<const monero_backend *> backends = supported(candidates);
+    return backends;
+}
+
+const std::vector<const monero_extra_backend *> &monero_extra_backends() {
+    static const monero_extra_backend *const candidates[] = {
+        &detail::monero_extra_aesni,
+        &detail::monero_extra_sse41,
+        &detail::monero_extra_sse2,
+        &detail::monero_extra_portable,
+    };
+    static const std::vector<const monero_extra_backend *> backends = supported(candidates);
+    return backends;
+}
+
+const std::vector<const keccak_backend *> &keccak_backends() {
+    static const keccak_backend *const candidates[] = {
+        &detail::keccak_avx512f,
+        &detail::keccak_avx2,
+        &detail::keccak_portable,
+    };
+    static const std::vector<const keccak_backend *> backends = supported(candidates);
+    return backends;
+}
+
+const cryptonight_kernel *cryptonight(const char *algorithm) {
+    for (auto backend : monero_backends()) {
+        for (size_t i = 0; i < backend->kernel_count; i++) {
+            if (strcmp(backend->kernels[i].algorithm, algorithm) == 0) {
+                return &backend->kernels[i];
+            }
+        }
+    }
+    return nullptr;
+}
+
+const sha256_backend &sha256() {
+    static const sha256_backend &best = *sha256_backends().front();
+    return best;
+}
+
+const sha256_backend &sha256_single() {
+    static const sha256_backend &best = *sha256_single_backends().front();
+    return best;
+}
+
+const monero_backend &monero() {
+    static const monero_backend &best = *monero_backends().front();
+    return best;
+}
+
+const keccak_backend &keccak() {
+    static const keccak_backend &best = *keccak_backends().front();
+    return best;
+}
+
+const monero_extra_hash *monero_extra() {
+    struct table {
+        monero_extra_hash extra[4];
+    };
+    static const table best = [] {
+        table r = {};
+        for (int i = 0; i < 4; i++) {
+            for (auto backend : monero_extra_backends()) {
+                if (backend->extra[i]) {
+                    r.extra[i] = backend->extra[i];
+                    break;
+                }
+            }
+        }
+        return r;
+    }();
+    return best.extra;
+}
+
+} // namespace dispatch
+} // namespace fingera
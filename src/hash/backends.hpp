@@ -0,0 +1,33 @@
+#pragma once
+
+#include <fingera/dispatch.hpp>
+
+// Every backend lives in a translation unit compiled with its own target
+// flags (see CMakeLists.txt), only these tables cross the boundary.
+namespace fingera {
+namespace dispatch {
+namespace detail {
+
+extern const sha256_backend sha256_generic;
+extern const sha256_backend sha256_sse2;
+extern const sha256_backend sha256_avx2;
+extern const sha256_backend sha256_avx512f;
+extern const sha256_backend sha256_shani;
+
+extern const monero_backend monero_vaes;
+extern const monero_backend monero_aesni;
+extern const monero_backend monero_softaes;
+extern const monero_backend monero_portable;
+
+extern const monero_extra_backend monero_extra_aesni;
+extern const monero_extra_backend monero_extra_sse41;
+extern const monero_extra_backend monero_extra_sse2;
+extern const monero_extra_backend monero_extra_portable;
+
+extern const keccak_backend keccak_avx512f;
+extern const keccak_backend keccak_avx2;
+extern const keccak_backend keccak_portable;
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <fingera/config.hpp>
+#include <fingera/hash/monero.hpp>
+
+// CryptoNight family members, shared by the monero_*.cpp backends. Each
+// backend instantiates its kernels for every member so memory size,
+// iteration count and index mask are compile time constants.
+namespace fingera {
+namespace hash {
+namespace cn {
+
+// Iterations counts main loop rounds, two scratchpad accesses each.
+// Mask keeps scratchpad offsets 16 aligned and inside Memory.
+// Variant 1 adds the monero v7 tweak (0x7531 table and tweak1_2), variant 2
+// (monero v8) the shuffle of the neighbouring lines and the integer math,
+// variant 4 (CryptoNight-R) replaces the integer math by random math.
+template<size_t Memory, size_t Iterations, int Variant, uint32_t Mask = Memory - 16>
+struct params {
+    static const size_t memory = Memory;
+    static const size_t iterations = Iterations;
+    static const uint32_t mask = Mask;
+    static const int variant = Variant;
+};
+
+using v0 = params<1 << 21, 1 << 19, 0>;        // "cn/0", original
+using v1 = params<1 << 21, 1 << 19, 1>;        // "cn/1", monero v7
+using msr = params<1 << 21, 1 << 18, 1>;       // "cn/msr", cn/1 with half the rounds
+using v2 = params<1 << 21, 1 << 19, 2>;        // "cn/2", monero v8
+using half = params<1 << 21, 1 << 18, 2>;      // "cn/half", cn/2 with half the rounds
+using r = params<1 << 21, 1 << 19, 4>;         // "cn/r", monero v10
+using lite_v0 = params<1 << 20, 1 << 18, 0>;   // "cn-lite/0"
+using lite_v1 = params<1 << 20, 1 << 18, 1>;   // "cn-lite/1"
+
+// One random math instruction, false on ret
+static inline FINGERA_FORCEINLINE bool r_exec(const cryptonight_r_program::instruction &op, uint32_t *r) {
+    const uint32_t src = r[op.src];
+    uint32_t &dst = r[op.dst];
+    switch (op.opcode) {
+    case cryptonight_r_program::mul:
+        dst *= src;
+        break;
+    case cryptonight_r_program::add:
+        dst += src + op.c;
+        break;
+    case cryptonight_r_program::sub:
+        dst -= src;
+        break;
+    case cryptonight_r_program::ror:
+        dst = (dst >> (src % 32)) | (dst << ((32 - src % 32) % 32));
+        break;
+    case cryptonight_r_program::rol:
+        dst = (dst << (src % 32)) | (dst >> ((32 - src % 32) % 32));
+        break;
+    case cryptonight_r_program::xor_:
+        dst ^= src;
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+// Unrolled: every instruction has its own switch, which goes the same way
+// in every main loop round
+template<int... I>
+static inline FINGERA_FORCEINLINE void r_interpret(const cryptonight_r_program::instruction *code, uint32_t *r,
+        std::integer_sequence<int, I...>) {
+    bool running = true;
+    int order[] = {(running = running && r_exec(code[I], r), 0)...};
+    (void)order;
+}
+
+static inline FINGERA_FORCEINLINE void r_run(const cryptonight_r_program &program, uint32_t *r) {
+    if (program.native()) {
+        program.native()(r);
+    } else {
+        r_interpret(program.code(), r, std::make_integer_sequence<int, cryptonight_r_program::max_size + 1>());
+    }
+}
+
+} // namespace cn
+} // namespace hash
+} // namespace fingera
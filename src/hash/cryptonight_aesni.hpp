@@ -0,0 +1,440 @@
+#pragma once
+
+// The AES-NI CryptoNight kernels, included by every backend built on them
+// (monero_aesni.cpp, monero_vaes.cpp) and compiled with that backend's
+// target flags. Everything is static: each translation unit gets its own
+// copy. Scratchpad selects how scratchpads are exploded and imploded,
+// Scratchpad::aes the AES round (AES-NI or tables, cn_aes_hw below).
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <fingera/config.hpp>
+#include <fingera/dispatch.hpp>
+#include "cryptonight.hpp"
+#include "keccak.hpp"
+extern "C" {
+#include "monero/hash-ops.h"
+}
+#include <immintrin.h>
+
+namespace fingera {
+namespace hash {
+
+#if defined(__AES__)
+// _mm_aesenc_si128 and _mm_aeskeygenassist_si128, -maes translation units only
+struct cn_aes_hw {
+    static inline FINGERA_FORCEINLINE __m128i enc(__m128i x, __m128i key) {
+        return _mm_aesenc_si128(x, key);
+    }
+
+    template<uint8_t rcon>
+    static inline FINGERA_FORCEINLINE __m128i keygenassist(__m128i x) {
+        return _mm_aeskeygenassist_si128(x, rcon);
+    }
+};
+#endif
+
+// This will shift and xor tmp1 into itself as 4 32-bit vals such as
+// sl_xor(a1 a2 a3 a4) = a1 (a2^a1) (a3^a2^a1) (a4^a3^a2^a1)
+static inline __m128i sl_xor(__m128i tmp1) {
+    __m128i tmp4;
+    tmp4 = _mm_slli_si128(tmp1, 0x04);
+    tmp1 = _mm_xor_si128(tmp1, tmp4);
+    tmp4 = _mm_slli_si128(tmp4, 0x04);
+    tmp1 = _mm_xor_si128(tmp1, tmp4);
+    tmp4 = _mm_slli_si128(tmp4, 0x04);
+    tmp1 = _mm_xor_si128(tmp1, tmp4);
+    return tmp1;
+}
+
+template<typename Aes, uint8_t rcon>
+static inline void aes_genkey_sub(__m128i* xout0, __m128i* xout2) {
+    __m128i xout1 = Aes::template keygenassist<rcon>(*xout2);
+    xout1  = _mm_shuffle_epi32(xout1, 0xFF); // see PSHUFD, set all elems to 4th elem
+    *xout0 = sl_xor(*xout0);
+    *xout0 = _mm_xor_si128(*xout0, xout1);
+    xout1  = Aes::template keygenassist<0x00>(*xout0);
+    xout1  = _mm_shuffle_epi32(xout1, 0xAA); // see PSHUFD, set all elems to 3rd elem
+    *xout2 = sl_xor(*xout2);
+    *xout2 = _mm_xor_si128(*xout2, xout1);
+}
+
+template<typename Aes>
+static inline void aes_expand_key(const __m128i* memory, __m128i* k0, __m128i* k1, __m128i* k2, __m128i* k3, __m128i* k4, __m128i* k5, __m128i* k6, __m128i* k7, __m128i* k8, __m128i* k9) {
+    __m128i xout0 = _mm_load_si128(memory);
+    __m128i xout2 = _mm_load_si128(memory + 1);
+    *k0 = xout0;
+    *k1 = xout2;
+
+    aes_genkey_sub<Aes, 0x01>(&xout0, &xout2);
+    *k2 = xout0;
+    *k3 = xout2;
+
+    aes_genkey_sub<Aes, 0x02>(&xout0, &xout2);
+    *k4 = xout0;
+    *k5 = xout2;
+
+    aes_genkey_sub<Aes, 0x04>(&xout0, &xout2);
+    *k6 = xout0;
+    *k7 = xout2;
+
+    aes_genkey_sub<Aes, 0x08>(&xout0, &xout2);
+    *k8 = xout0;
+    *k9 = xout2;
+}
+
+template<typename Aes>
+static inline void aes_round(__m128i key, __m128i* x0, __m128i* x1, __m128i* x2, __m128i* x3, __m128i* x4, __m128i* x5, __m128i* x6, __m128i* x7) {
+    *x0 = Aes::enc(*x0, key);
+    *x1 = Aes::enc(*x1, key);
+    *x2 = Aes::enc(*x2, key);
+    *x3 = Aes::enc(*x3, key);
+    *x4 = Aes::enc(*x4, key);
+    *x5 = Aes::enc(*x5, key);
+    *x6 = Aes::enc(*x6, key);
+    *x7 = Aes::enc(*x7, key);
+}
+
+template<size_t Memory, typename Aes>
+static inline void cn_explode_scratchpad(const __m128i *input, __m128i *output) {
+    __m128i k0, k1, k2, k3, k4, k5, k6, k7, k8, k9;
+    aes_expand_key<Aes>(input, &k0, &k1, &k2, &k3, &k4, &k5, &k6, &k7, &k8, &k9);
+
+    __m128i xin0, xin1, xin2, xin3, xin4, xin5, xin6, xin7;
+    xin0 = _mm_load_si128(input + 4);
+    xin1 = _mm_load_si128(input + 5);
+    xin2 = _mm_load_si128(input + 6);
+    xin3 = _mm_load_si128(input + 7);
+    xin4 = _mm_load_si128(input + 8);
+    xin5 = _mm_load_si128(input + 9);
+    xin6 = _mm_load_si128(input + 10);
+    xin7 = _mm_load_si128(input + 11);
+
+    for (size_t i = 0; i < Memory / 16; i += 8) {
+        aes_round<Aes>(k0, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+        aes_round<Aes>(k1, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+        aes_round<Aes>(k2, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+        aes_round<Aes>(k3, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+        aes_round<Aes>(k4, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+        aes_round<Aes>(k5, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+        aes_round<Aes>(k6, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+        aes_round<Aes>(k7, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+        aes_round<Aes>(k8, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+        aes_round<Aes>(k9, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
+
+        _mm_store_si128(output + i + 0, xin0);
+        _mm_store_si128(output + i + 1, xin1);
+        _mm_store_si128(output + i + 2, xin2);
+        _mm_store_si128(output + i + 3, xin3);
+        _mm_store_si128(output + i + 4, xin4);
+        _mm_store_si128(output + i + 5, xin5);
+        _mm_store_si128(output + i + 6, xin6);
+        _mm_store_si128(output + i + 7, xin7);
+    }
+}
+
+template<size_t Memory, typename Aes>
+static inline void cn_implode_scratchpad(const __m128i *input, __m128i *output)
+{
+    __m128i xout0, xout1, xout2, xout3, xout4, xout5, xout6, xout7;
+    __m128i k0, k1, k2, k3, k4, k5, k6, k7, k8, k9;
+
+    aes_expand_key<Aes>(output + 2, &k0, &k1, &k2, &k3, &k4, &k5, &k6, &k7, &k8, &k9);
+
+    xout0 = _mm_load_si128(output + 4);
+    xout1 = _mm_load_si128(output + 5);
+    xout2 = _mm_load_si128(output + 6);
+    xout3 = _mm_load_si128(output + 7);
+    xout4 = _mm_load_si128(output + 8);
+    xout5 = _mm_load_si128(output + 9);
+    xout6 = _mm_load_si128(output + 10);
+    xout7 = _mm_load_si128(output + 11);
+
+    for (size_t i = 0; i < Memory / 16; i += 8)
+    {
+        xout0 = _mm_xor_si128(_mm_load_si128(input + i + 0), xout0);
+        xout1 = _mm_xor_si128(_mm_load_si128(input + i + 1), xout1);
+        xout2 = _mm_xor_si128(_mm_load_si128(input + i + 2), xout2);
+        xout3 = _mm_xor_si128(_mm_load_si128(input + i + 3), xout3);
+        xout4 = _mm_xor_si128(_mm_load_si128(input + i + 4), xout4);
+        xout5 = _mm_xor_si128(_mm_load_si128(input + i + 5), xout5);
+        xout6 = _mm_xor_si128(_mm_load_si128(input + i + 6), xout6);
+        xout7 = _mm_xor_si128(_mm_load_si128(input + i + 7), xout7);
+
+        aes_round<Aes>(k0, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+        aes_round<Aes>(k1, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+        aes_round<Aes>(k2, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+        aes_round<Aes>(k3, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+        aes_round<Aes>(k4, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+        aes_round<Aes>(k5, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+        aes_round<Aes>(k6, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+        aes_round<Aes>(k7, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+        aes_round<Aes>(k8, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+        aes_round<Aes>(k9, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+    }
+
+    _mm_store_si128(output + 4, xout0);
+    _mm_store_si128(output + 5, xout1);
+    _mm_store_si128(output + 6, xout2);
+    _mm_store_si128(output + 7, xout3);
+    _mm_store_si128(output + 8, xout4);
+    _mm_store_si128(output + 9, xout5);
+    _mm_store_si128(output + 10, xout6);
+    _mm_store_si128(output + 11, xout7);
+}
+
+// one 128 bit line at a time, 8 lines in flight
+template<typename Aes>
+struct cn_scratchpad_aes {
+    using aes = Aes;
+
+    template<size_t Memory, int N>
+    static inline void explode(const __m128i *const *states, __m128i *const *scratchpads) {
+        for (int n = 0; n < N; n++) {
+            cn_explode_scratchpad<Memory, Aes>(states[n], scratchpads[n]);
+        }
+    }
+
+    template<size_t Memory, int N>
+    static inline void implode(const __m128i *const *scratchpads, __m128i *const *states) {
+        for (int n = 0; n < N; n++) {
+            cn_implode_scratchpad<Memory, Aes>(scratchpads[n], states[n]);
+        }
+    }
+};
+
+static inline uint64_t umul128(uint64_t a, uint64_t b, uint64_t *hi) {
+    unsigned __int128 r = (unsigned __int128)a * b;
+    *hi = (uint64_t)(r >> 64);
+    return (uint64_t)r;
+}
+
+// floor(2 * sqrt(2^64 + n)) - 2^33: the double precision square root of the
+// top 52 bits is off by at most one, fixed with one multiply
+static inline uint64_t cn_sqrt_v2(uint64_t n) {
+    const __m128i exp_double_bias = _mm_set_epi64x(0, 1023ULL << 52);
+    __m128d x = _mm_castsi128_pd(_mm_add_epi64(_mm_cvtsi64_si128(n >> 12), exp_double_bias));
+    x = _mm_sqrt_sd(_mm_setzero_pd(), x);
+    uint64_t r = (uint64_t)_mm_cvtsi128_si64(_mm_sub_epi64(_mm_castpd_si128(x), exp_double_bias)) >> 19;
+
+    const uint64_t s = r >> 1;
+    const uint64_t b = r & 1;
+    const uint64_t r2 = s * (s + b) + (r << 32);
+    r += ((r2 + b > n) ? -1 : 0) + ((r2 + (1ULL << 32) < n - s) ? 1 : 0);
+    return r;
+}
+
+// variant 2: the three other 16 bytes lines of the 64 bytes around offset
+// are rotated, each plus one of b1, b, a. Variant 4 also xors the old lines
+// into c.
+template<int Variant>
+static inline FINGERA_FORCEINLINE void cn_shuffle_add_v2(uint8_t *l, size_t offset, __m128i a, __m128i b, __m128i b1,
+        __m128i &c) {
+    const __m128i chunk1 = _mm_load_si128((__m128i *)&l[offset ^ 0x10]);
+    const __m128i chunk2 = _mm_load_si128((__m128i *)&l[offset ^ 0x20]);
+    const __m128i chunk3 = _mm_load_si128((__m128i *)&l[offset ^ 0x30]);
+    _mm_store_si128((__m128i *)&l[offset ^ 0x10], _mm_add_epi64(chunk3, b1));
+    _mm_store_si128((__m128i *)&l[offset ^ 0x20], _mm_add_epi64(chunk1, b));
+    _mm_store_si128((__m128i *)&l[offset ^ 0x30], _mm_add_epi64(chunk2, a));
+    if (Variant == 4) {
+        c = _mm_xor_si128(c, _mm_xor_si128(chunk3, _mm_xor_si128(chunk1, chunk2)));
+    }
+}
+
+// main loop state of one hash, bx1 and below only for variant 2 and 4
+struct cn_lane {
+    uint8_t *l;
+    uint64_t al, ah, idx, tweak1_2;
+    __m128i bx;
+    __m128i bx1, cx;
+    uint64_t division_result, sqrt_result;
+    const cryptonight_r_program *program;
+    uint32_t r[9];
+};
+
+template<typename Algo, typename Aes>
+static inline FINGERA_FORCEINLINE void cn_aes_step(cn_lane &s) {
+    void *m = &s.l[s.idx & Algo::mask];
+    __m128i cx = _mm_load_si128((__m128i *) m);
+    cx = Aes::enc(cx, _mm_set_epi64x(s.ah, s.al));
+    if (Algo::variant >= 2) {
+        cn_shuffle_add_v2<Algo::variant>(s.l, s.idx & Algo::mask, _mm_set_epi64x(s.ah, s.al), s.bx, s.bx1, cx);
+    }
+
+    __m128i tmp = _mm_xor_si128(s.bx, cx);
+    ((uint64_t *)m)[0] = _mm_cvtsi128_si64(tmp);
+
+    tmp = _mm_castps_si128(_mm_movehl_ps(_mm_castsi128_ps(tmp), _mm_castsi128_ps(tmp)));
+    uint64_t vh = _mm_cvtsi128_si64(tmp);
+    if (Algo::variant == 1) {
+        uint8_t x = vh >> 24;
+        static const uint16_t table = 0x7531;
+        const uint8_t index = (((x >> 3) & 6) | (x & 1)) << 1;
+        vh ^= ((table >> index) & 0x3) << 28;
+    }
+    ((uint64_t *)m)[1] = vh;
+
+    s.idx = _mm_cvtsi128_si64(cx);
+    if (Algo::variant >= 2) {
+        s.cx = cx;
+    } else {
+        s.bx = cx;
+    }
+}
+
+template<typename Algo>
+static inline FINGERA_FORCEINLINE void cn_mul_step(cn_lane &s) {
+    uint64_t *m = (uint64_t *)&s.l[s.idx & Algo::mask];
+    uint64_t hi, lo, cl, ch;
+    cl = m[0];
+    ch = m[1];
+    const __m128i a = _mm_set_epi64x(s.ah, s.al);
+    if (Algo::variant == 2) {
+        // the division stays on the integer divider: on current cores it
+        // is quicker than a double precision estimate plus fixup
+        cl ^= s.division_result ^ (s.sqrt_result << 32);
+        const uint64_t dividend = _mm_cvtsi128_si64(_mm_unpackhi_epi64(s.cx, s.cx));
+        const uint32_t divisor = (s.idx + (uint32_t)(s.sqrt_result << 1)) | 0x80000001UL;
+        s.division_result = (uint32_t)(dividend / divisor) + ((dividend % divisor) << 32);
+        s.sqrt_result = cn_sqrt_v2(s.idx + s.division_result);
+    }
+    if (Algo::variant == 4) {
+        uint32_t *r = s.r;
+        cl ^= (r[0] + r[1]) | ((uint64_t)(r[2] + r[3]) << 32);
+        r[4] = (uint32_t)s.al;
+        r[5] = (uint32_t)s.ah;
+        r[6] = (uint32_t)_mm_cvtsi128_si32(s.bx);
+        r[7] = (uint32_t)_mm_cvtsi128_si32(s.bx1);
+        r[8] = (uint32_t)_mm_cvtsi128_si32(_mm_unpackhi_epi64(s.bx1, s.bx1));
+        cn::r_run(*s.program, r);
+        s.al ^= r[2] | ((uint64_t)r[3] << 32);
+        s.ah ^= r[0] | ((uint64_t)r[1] << 32);
+    }
+    lo = umul128(s.idx, cl, &hi);
+    if (Algo::variant == 2) {
+        uint64_t *chunk1 = (uint64_t *)&s.l[(s.idx & Algo::mask) ^ 0x10];
+        const uint64_t *chunk2 = (const uint64_t *)&s.l[(s.idx & Algo::mask) ^ 0x20];
+        chunk1[0] ^= hi;
+        chunk1[1] ^= lo;
+        hi ^= chunk2[0];
+        lo ^= chunk2[1];
+    }
+    if (Algo::variant >= 2) {
+        cn_shuffle_add_v2<Algo::variant>(s.l, s.idx & Algo::mask, a, s.bx, s.bx1, s.cx);
+        s.bx1 = s.bx;
+        s.bx = s.cx;
+    }
+
+    s.al += hi;
+    s.ah += lo;
+
+    m[0] = s.al;
+    m[1] = s.ah ^ s.tweak1_2;
+
+    s.al ^= cl;
+    s.ah ^= ch;
+    s.idx = s.al;
+}
+
+// The AES half of every hash, then the multiply half of every hash: while
+// one chain waits on its scratchpad load or its multiply the others have
+// independent work. Expanded from a pack so the lanes stay in registers.
+template<typename Algo, typename Aes, int... N>
+static inline FINGERA_FORCEINLINE void cn_main_loop(cn_lane *s, std::integer_sequence<int, N...>) {
+    for (size_t i = 0; i < Algo::iterations; i++) {
+        int aes[] = {(cn_aes_step<Algo, Aes>(s[N]), 0)...};
+        int mul[] = {(cn_mul_step<Algo>(s[N]), 0)...};
+        (void)aes;
+        (void)mul;
+    }
+}
+
+// N hashes, scratchpad n at memory + n * Algo::memory, program for variant 4
+template<typename Algo, int N, typename Scratchpad>
+static void cn_hash_aesni(const void *const *block_blobs, const size_t *lengths, void *const *results, uint8_t *memory,
+        const cryptonight_r_program *program = nullptr) {
+    // major_version 1-2 current 1
+    // minor_version 1-2 current 1
+    // timestamp 1-10 current min 5()
+    // prev_id 32
+    // nonce 4
+    // tree_root_hash 32
+    // (tx_hashes.size()+1) 1-10
+    // 0-126 tx: 76
+    // 127-254 tx: 77
+    // accept: 76->80
+    alignas(16) uint8_t keccak_state[N][208]; // 200, rounded up to keep every row aligned
+    uint64_t *keccak_lanes[N];
+    cn_lane s[N];
+    __m128i *states[N];
+    __m128i *scratchpads[N];
+
+    /* CryptoNight Step 1:  Use Keccak1600 to initialize the 'state' (and 'text') buffers from the data. */
+    for (int n = 0; n < N; n++) keccak_lanes[n] = reinterpret_cast<uint64_t *>(keccak_state[n]);
+    keccak1600_many(block_blobs, lengths, N, keccak_lanes);
+
+    for (int n = 0; n < N; n++) {
+        assert(Algo::variant != 1 || lengths[n] >= 43); // the tweak reads the nonce
+
+        uint64_t *h = keccak_lanes[n];
+        s[n].tweak1_2 = Algo::variant == 1 ? h[24] ^ *((const uint64_t *)((const char *)block_blobs[n] + 35)) : 0;
+
+        s[n].l = memory + (size_t)n * Algo::memory;
+        states[n] = (__m128i *)keccak_state[n];
+        scratchpads[n] = (__m128i *)s[n].l;
+
+        s[n].al = h[0] ^ h[4];
+        s[n].ah = h[1] ^ h[5];
+        s[n].bx = _mm_set_epi64x(h[3] ^ h[7], h[2] ^ h[6]);
+        s[n].idx = s[n].al;
+        s[n].bx1 = _mm_set_epi64x(h[9] ^ h[11], h[8] ^ h[10]);
+        s[n].division_result = h[12];
+        s[n].sqrt_result = h[13];
+        s[n].program = program;
+        for (int i = 0; i < 4; i++) {
+            s[n].r[i] = ((const uint32_t *)&h[12])[i];
+        }
+    }
+
+    Scratchpad::template explode<Algo::memory, N>(states, scratchpads);
+    cn_main_loop<Algo, typename Scratchpad::aes>(s, std::make_integer_sequence<int, N>());
+    Scratchpad::template implode<Algo::memory, N>(scratchpads, states);
+
+    keccakf_many(keccak_lanes, N);
+    for (int n = 0; n < N; n++) {
+        uint64_t *h = keccak_lanes[n];
+        dispatch::monero_extra()[h[0] & 3](h, 200, (char *)results[n]);
+    }
+}
+
+template<typename Algo, typename Scratchpad>
+static void cn_kernel_aesni(const void *blob, size_t length, void *result, void *scratchpad) {
+    cn_hash_aesni<Algo, 1, Scratchpad>(&blob, &length, &result, (uint8_t *)scratchpad);
+}
+
+template<typename Algo, typename Scratchpad, int N>
+static void cn_kernel_multi_aesni(const void *const *blobs, const size_t *lengths, void *const *results,
+        void *scratchpad) {
+    cn_hash_aesni<Algo, N, Scratchpad>(blobs, lengths, results, (uint8_t *)scratchpad);
+}
+
+template<typename Scratchpad>
+static void cn_r_aesni(const void *blob, size_t length, void *result, void *scratchpad,
+        const cryptonight_r_program &program) {
+    cn_hash_aesni<cn::r, 1, Scratchpad>(&blob, &length, &result, (uint8_t *)scratchpad, &program);
+}
+
+template<typename Algo, typename Scratchpad>
+static constexpr dispatch::cryptonight_kernel make_kernel_aesni(const char *algorithm) {
+    return {algorithm, Algo::memory, &cn_kernel_aesni<Algo, Scratchpad>, {
+        &cn_kernel_multi_aesni<Algo, Scratchpad, 1>,
+        &cn_kernel_multi_aesni<Algo, Scratchpad, 2>,
+        &cn_kernel_multi_aesni<Algo, Scratchpad, 3>,
+        &cn_kernel_multi_aesni<Algo, Scratchpad, 4>,
+        &cn_kernel_multi_aesni<Algo, Scratchpad, 5>,
+    }};
+}
+
+} // namespace hash
+} // namespace fingera
+
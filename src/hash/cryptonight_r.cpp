@@ -0,0 +1,329 @@
+#include <cstring>
+#include <new>
+#include <fingera/endian.hpp>
+#include <fingera/hash/monero.hpp>
+#include "cryptonight.hpp"
+extern "C" {
+#include "monero/hash-ops.h"
+}
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+namespace fingera {
+namespace hash {
+
+using program = cryptonight_r_program;
+
+enum {
+    // minimal latency of the generated code, 15 multiplications
+    total_latency = 15 * 3,
+    min_size = 60,
+    // one ALU can multiply, three run the random math next to the main loop
+    alu_count_mul = 1,
+    alu_count = 3,
+};
+
+// more random bytes: blake256 of the previous ones
+static void check_data(size_t &data_index, size_t bytes_needed, int8_t *data, size_t data_size) {
+    if (data_index + bytes_needed > data_size) {
+        hash_extra_blake(data, data_size, (char *)data);
+        data_index = 0;
+    }
+}
+
+// monero's v4_random_math_init: as many instructions as the latency and
+// ALU budget of an abstract CPU allows, every byte sequence is valid code
+void cryptonight_r_program::_generate() {
+    // MUL 3 cycles, 3-way ADD and rotations 2, SUB/XOR 1 (Sandy Bridge .. Coffee Lake)
+    static const int op_latency[ret] = {3, 2, 1, 2, 2, 1};
+    static const int asic_op_latency[ret] = {3, 1, 1, 1, 1, 1};
+    static const int op_alus[ret] = {alu_count_mul, alu_count, alu_count, alu_count, alu_count, alu_count};
+
+    int8_t data[32];
+    memset(data, 0, sizeof(data));
+    write_little<uint64_t>(data, _height);
+    data[20] = -38; // change seed
+    size_t data_index = sizeof(data);
+
+    bool r8_used;
+    do {
+        int latency[9] = {0};
+        int asic_latency[9] = {0};
+        // per register: code index, opcode << 8, source value << 16 of the
+        // last write; r4 .. r8 are constant and all alike
+        uint32_t inst_data[9] = {0, 1, 2, 3, 0xFFFFFF, 0xFFFFFF, 0xFFFFFF, 0xFFFFFF, 0xFFFFFF};
+        bool alu_busy[total_latency + 1][alu_count];
+        bool is_rotation[ret] = {false, false, false, true, true, false};
+        bool rotated[4] = {false};
+        int rotate_count = 0;
+        memset(alu_busy, 0, sizeof(alu_busy));
+
+        int num_retries = 0;
+        int total_iterations = 0;
+        _size = 0;
+        r8_used = false;
+
+        while ((latency[0] < total_latency || latency[1] < total_latency ||
+                latency[2] < total_latency || latency[3] < total_latency) && num_retries < 64) {
+            if (++total_iterations > 256) break;
+
+            check_data(data_index, 1, data, sizeof(data));
+            const uint8_t c = (uint8_t)data[data_index++];
+
+            // MUL 0-2, ADD 3, SUB 4, ROR/ROL 5, XOR 6-7
+            uint8_t opcode = c & 7;
+            if (opcode == 5) {
+                check_data(data_index, 1, data, sizeof(data));
+                opcode = data[data_index++] >= 0 ? ror : rol;
+            } else if (opcode >= 6) {
+                opcode = xor_;
+            } else {
+                opcode = opcode <= 2 ? mul : opcode - 2;
+            }
+
+            uint8_t dst_index = (c >> 3) & 3;
+            uint8_t src_index = (c >> 5) & 7;
+            const int a = dst_index;
+            int b = src_index;
+
+            // ADD/SUB/XOR with itself: use r8 instead
+            if ((opcode == add || opcode == sub || opcode == xor_) && a == b) {
+                b = 8;
+                src_index = 8;
+            }
+            // two rotations in a row are one rotation
+            if (is_rotation[opcode] && rotated[a]) continue;
+            // the same instruction with the same source twice folds into one
+            if (opcode != mul && (inst_data[a] & 0xFFFF00) == (uint32_t)(opcode << 8) + ((inst_data[b] & 255) << 16)) {
+                continue;
+            }
+
+            // first cycle an ALU is free for it
+            int next_latency = latency[a] > latency[b] ? latency[a] : latency[b];
+            int alu_index = -1;
+            while (next_latency < total_latency) {
+                for (int i = op_alus[opcode] - 1; i >= 0; --i) {
+                    if (alu_busy[next_latency][i]) continue;
+                    // ADD is two 1-cycle instructions
+                    if (opcode == add && alu_busy[next_latency + 1][i]) continue;
+                    // a rotation waits for the previous one
+                    if (is_rotation[opcode] && next_latency < rotate_count * op_latency[opcode]) continue;
+                    alu_index = i;
+                    break;
+                }
+                if (alu_index >= 0) break;
+                ++next_latency;
+            }
+
+            // no register unchanged for more than 7 cycles
+            if (next_latency > latency[a] + 7) continue;
+
+            next_latency += op_latency[opcode];
+            if (next_latency <= total_latency) {
+                if (is_rotation[opcode]) ++rotate_count;
+                alu_busy[next_latency - op_latency[opcode]][alu_index] = true;
+                latency[a] = next_latency;
+                asic_latency[a] = (asic_latency[a] > asic_latency[b] ? asic_latency[a] : asic_latency[b]) +
+                    asic_op_latency[opcode];
+                rotated[a] = is_rotation[opcode];
+                inst_data[a] = _size + (opcode << 8) + ((inst_data[b] & 255) << 16);
+
+                instruction &op = _code[_size];
+                op.opcode = opcode;
+                op.dst = dst_index;
+                op.src = src_index;
+                op.c = 0;
+                if (src_index == 8) r8_used = true;
+                if (opcode == add) {
+                    alu_busy[next_latency - op_latency[opcode] + 1][alu_index] = true;
+                    check_data(data_index, sizeof(uint32_t), data, sizeof(data));
+                    op.c = read_little<uint32_t>(data + data_index);
+                    data_index += sizeof(uint32_t);
+                }
+                if (++_size >= min_size) break;
+            } else {
+                ++num_retries;
+            }
+        }
+
+        // an ASIC runs every independent instruction at once: more MUL and
+        // ROR until one register reaches the latency there too
+        const int prev_size = _size;
+        while (_size < max_size && asic_latency[0] < total_latency && asic_latency[1] < total_latency &&
+                asic_latency[2] < total_latency && asic_latency[3] < total_latency) {
+            int min_idx = 0;
+            int max_idx = 0;
+            for (int i = 1; i < 4; ++i) {
+                if (asic_latency[i] < asic_latency[min_idx]) min_idx = i;
+                if (asic_latency[i] > asic_latency[max_idx]) max_idx = i;
+            }
+            static const uint8_t pattern[3] = {ror, mul, mul};
+            const uint8_t opcode = pattern[(_size - prev_size) % 3];
+            latency[min_idx] = latency[max_idx] + op_latency[opcode];
+            asic_latency[min_idx] = asic_latency[max_idx] + asic_op_latency[opcode];
+
+            instruction &op = _code[_size++];
+            op.opcode = opcode;
+            op.dst = min_idx;
+            op.src = max_idx;
+            op.c = 0;
+        }
+    } while (!r8_used || _size < min_size || _size > max_size);
+
+    _code[_size] = instruction{ret, 0, 0, 0};
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+// r0 .. r3 live in r8d .. r11d, r4 .. r8 are read from [rdi + 4 * i], ecx
+// holds rotation counts. Only caller-saved registers on System V; Windows
+// passes r in rcx and needs rdi saved.
+static uint8_t *emit_byte(uint8_t *p, uint8_t b) {
+    *p++ = b;
+    return p;
+}
+
+static uint8_t *emit_modrm_mem(uint8_t *p, int reg, int index) {
+    p = emit_byte(p, 0x40 | ((reg & 7) << 3) | 7);    // [rdi + disp8]
+    return emit_byte(p, (uint8_t)(index * 4));
+}
+
+static uint8_t *emit_program(uint8_t *p, const program::instruction *code) {
+#if defined(_WIN32)
+    p = emit_byte(p, 0x57);                 // push rdi
+    p = emit_byte(p, 0x48);                 // mov rdi, rcx
+    p = emit_byte(p, 0x89);
+    p = emit_byte(p, 0xCF);
+#endif
+    for (int i = 0; i < 4; i++) {           // mov r8d + i, [rdi + 4 * i]
+        p = emit_byte(p, 0x44);
+        p = emit_byte(p, 0x8B);
+        p = emit_modrm_mem(p, i, i);
+    }
+    for (const program::instruction *op = code; op->opcode != program::ret; op++) {
+        const int dst = op->dst;
+        const int src = op->src;
+        switch (op->opcode) {
+        case program::mul:                  // imul dst, src
+            p = emit_byte(p, src < 4 ? 0x45 : 0x44);
+            p = emit_byte(p, 0x0F);
+            p = emit_byte(p, 0xAF);
+            p = src < 4 ? emit_byte(p, 0xC0 | (dst << 3) | src) : emit_modrm_mem(p, dst, src);
+            break;
+        case program::add:
+        case program::sub:
+        case program::xor_: {               // op dst, src
+            static const uint8_t reg_op[] = {0, 0x01, 0x29, 0, 0, 0x31};
+            static const uint8_t mem_op[] = {0, 0x03, 0x2B, 0, 0, 0x33};
+            if (src < 4) {
+                p = emit_byte(p, 0x45);
+                p = emit_byte(p, reg_op[op->opcode]);
+                p = emit_byte(p, 0xC0 | (src << 3) | dst);
+            } else {
+                p = emit_byte(p, 0x44);
+                p = emit_byte(p, mem_op[op->opcode]);
+                p = emit_modrm_mem(p, dst, src);
+            }
+            if (op->opcode == program::add) {   // add dst, imm32
+                p = emit_byte(p, 0x41);
+                p = emit_byte(p, 0x81);
+                p = emit_byte(p, 0xC0 | dst);
+                write_little<uint32_t>(p, op->c);
+                p += 4;
+            }
+            break;
+        }
+        case program::ror:
+        case program::rol:
+            if (src < 4) {                  // mov ecx, src
+                p = emit_byte(p, 0x44);
+                p = emit_byte(p, 0x89);
+                p = emit_byte(p, 0xC1 | (src << 3));
+            } else {
+                p = emit_byte(p, 0x8B);
+                p = emit_modrm_mem(p, 1, src);
+            }
+            p = emit_byte(p, 0x41);         // ror/rol dst, cl
+            p = emit_byte(p, 0xD3);
+            p = emit_byte(p, 0xC0 | ((op->opcode == program::ror ? 1 : 0) << 3) | dst);
+            break;
+        }
+    }
+    for (int i = 0; i < 4; i++) {           // mov [rdi + 4 * i], r8d + i
+        p = emit_byte(p, 0x44);
+        p = emit_byte(p, 0x89);
+        p = emit_modrm_mem(p, i, i);
+    }
+#if defined(_WIN32)
+    p = emit_byte(p, 0x5F);                 // pop rdi
+#endif
+    return emit_byte(p, 0xC3);              // ret
+}
+
+// 4 loads, at most 70 * 11 bytes, 4 stores, prologue and ret
+static const size_t native_size = 4096;
+
+static void *alloc_native() {
+#if defined(_WIN32)
+    return VirtualAlloc(nullptr, native_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    void *p = mmap(nullptr, native_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#endif
+}
+
+static bool protect_native(void *buffer) {
+#if defined(_WIN32)
+    DWORD old;
+    return VirtualProtect(buffer, native_size, PAGE_EXECUTE_READ, &old) != 0;
+#else
+    return mprotect(buffer, native_size, PROT_READ | PROT_EXEC) == 0;
+#endif
+}
+
+static void free_native(void *buffer) {
+#if defined(_WIN32)
+    VirtualFree(buffer, 0, MEM_RELEASE);
+#else
+    munmap(buffer, native_size);
+#endif
+}
+
+// writable, then executable: never both
+void cryptonight_r_program::_compile() {
+    _buffer = alloc_native();
+    if (!_buffer) return;
+    emit_program((uint8_t *)_buffer, _code);
+    if (!protect_native(_buffer)) {
+        free_native(_buffer);
+        _buffer = nullptr;
+        return;
+    }
+    _native = (void (*)(uint32_t *))_buffer;
+}
+#else
+void cryptonight_r_program::_compile() {
+}
+
+static void free_native(void *) {
+}
+#endif
+
+cryptonight_r_program::cryptonight_r_program(uint64_t height, bool jit)
+        : _height(height), _size(0), _native(nullptr), _buffer(nullptr) {
+    _generate();
+    if (jit) _compile();
+}
+
+cryptonight_r_program::~cryptonight_r_program() {
+    if (_buffer) free_native(_buffer);
+}
+
+void cryptonight_r_program::run(uint32_t *r) const {
+    cn::r_run(*this, r);
+}
+
+} // namespace hash
+} // namespace fingera
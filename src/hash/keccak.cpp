@@ -0,0 +1,194 @@
+#include <cstdint>
+#include <cstring>
+#include <fingera/config.hpp>
+#include <fingera/dispatch.hpp>
+#include <fingera/endian.hpp>
+#include <fingera/hash/monero.hpp>
+#include "backends.hpp"
+#include "keccak.hpp"
+
+namespace fingera {
+namespace hash {
+
+// Lane complementing (the Keccak team's "bebigokimisa"): with lanes 1, 2,
+// 8, 12, 17 and 20 kept complemented between rounds, chi needs one NOT per
+// row instead of five, the others folded into AND and OR. Row y of chi,
+// lane x: a ^ (b op c) with op and the negated input from this table.
+struct keccak_chi_step {
+    bool or_;
+    int negate;     // 0 none, 1 b, 2 c, 3 a
+};
+
+static constexpr keccak_chi_step keccak_chi[25] = {
+    {true, 0}, {true, 1}, {false, 0}, {true, 0}, {false, 0},
+    {true, 0}, {false, 0}, {true, 2}, {true, 0}, {false, 0},
+    {true, 0}, {false, 0}, {false, 1}, {true, 3}, {false, 0},
+    {false, 0}, {true, 0}, {true, 1}, {false, 3}, {true, 0},
+    {false, 1}, {true, 3}, {false, 0}, {true, 0}, {false, 0},
+};
+
+static constexpr int keccak_complemented[6] = {1, 2, 8, 12, 17, 20};
+
+struct keccak_scalar {
+    using type = uint64_t;
+
+    static inline FINGERA_FORCEINLINE uint64_t xor_(uint64_t a, uint64_t b) { return a ^ b; }
+    static inline FINGERA_FORCEINLINE uint64_t xor5(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e) {
+        return a ^ b ^ c ^ d ^ e;
+    }
+    template<int N>
+    static inline FINGERA_FORCEINLINE uint64_t rotl(uint64_t x) { return (x << N) | (x >> ((64 - N) & 63)); }
+    template<int I>
+    static inline FINGERA_FORCEINLINE uint64_t chi(uint64_t a, uint64_t b, uint64_t c) {
+        const keccak_chi_step step = keccak_chi[I];
+        if (step.negate == 1) b = ~b;
+        if (step.negate == 2) c = ~c;
+        if (step.negate == 3) a = ~a;
+        return a ^ (step.or_ ? b | c : b & c);
+    }
+    static inline FINGERA_FORCEINLINE uint64_t constant(uint64_t rc) { return rc; }
+};
+
+void keccakf(uint64_t *state) {
+    uint64_t a[25];
+    for (int i = 0; i < 25; i++) a[i] = state[i];
+    for (int i : keccak_complemented) a[i] = ~a[i];
+    keccak::permute<keccak_scalar>(a);
+    for (int i : keccak_complemented) a[i] = ~a[i];
+    for (int i = 0; i < 25; i++) state[i] = a[i];
+}
+
+void keccakf_many(uint64_t *const *states, size_t count) {
+    const dispatch::keccak_backend &backend = dispatch::keccak();
+    const size_t way = backend.way;
+    size_t n = 0;
+    for (; count - n >= way; n += way) backend.keccakf(states + n);
+    if (count - n == 1) {
+        keccakf(states[n]);
+    } else if (count > n) {
+        // idle lanes permute spare states
+        uint64_t spare[8][25] = {};
+        uint64_t *lanes[8];
+        for (size_t i = 0; i < way; i++) lanes[i] = n + i < count ? states[n + i] : spare[i];
+        backend.keccakf(lanes);
+    }
+}
+
+// xors the next 136 bytes block of data into state, the padded last one
+// (0x01, zeros, 0x80) when less is left. True after the last block.
+static inline bool keccak_absorb(uint64_t *state, const uint8_t *data, size_t length, size_t &offset) {
+    const uint8_t *in = data + offset;
+    uint8_t last[136];
+    const bool done = length - offset < sizeof(last);
+    if (done) {
+        memset(last, 0, sizeof(last));
+        memcpy(last, in, length - offset);
+        last[length - offset] = 0x01;
+        last[sizeof(last) - 1] |= 0x80;
+        in = last;
+    }
+    offset += sizeof(last);
+    for (int i = 0; i < 17; i++) state[i] ^= read_little<uint64_t>(in + 8 * i);
+    return done;
+}
+
+void keccak1600(const void *data, size_t length, uint64_t *state) {
+    memset(state, 0, 200);
+    size_t offset = 0;
+    bool done;
+    do {
+        done = keccak_absorb(state, (const uint8_t *)data, length, offset);
+        keccakf(state);
+    } while (!done);
+}
+
+// Sponges of count messages on the lanes of the fastest backend: every
+// step absorbs one block per busy lane and permutes all lanes at once, a
+// lane whose message ended takes the next one. state(lane, n) is where
+// message n absorbs, finish(n, state) runs after its last permutation.
+template<typename State, typename Finish>
+static void keccak_sponges(const void *const *messages, const size_t *lengths, size_t count, State state,
+        Finish finish) {
+    const dispatch::keccak_backend &backend = dispatch::keccak();
+    if (backend.way == 1 || count == 1) {
+        for (size_t n = 0; n < count; n++) {
+            uint64_t *s = state(0, n);
+            keccak1600(messages[n], lengths[n], s);
+            finish(n, s);
+        }
+        return;
+    }
+
+    const size_t idle = (size_t)-1;
+    uint64_t spare[8][25] = {};
+    uint64_t *lanes[8];
+    size_t message[8], offset[8];
+    bool done[8];
+    size_t next = 0;
+    auto refill = [&](int i) {
+        if (next < count) {
+            message[i] = next;
+            lanes[i] = state(i, next++);
+            memset(lanes[i], 0, 200);
+        } else {
+            message[i] = idle;
+            lanes[i] = spare[i];
+        }
+        offset[i] = 0;
+    };
+    for (int i = 0; i < backend.way; i++) refill(i);
+    while (true) {
+        bool busy = false;
+        for (int i = 0; i < backend.way; i++) {
+            done[i] = false;
+            if (message[i] == idle) continue;
+            busy = true;
+            done[i] = keccak_absorb(lanes[i], (const uint8_t *)messages[message[i]], lengths[message[i]], offset[i]);
+        }
+        if (!busy) break;
+        backend.keccakf(lanes);
+        for (int i = 0; i < backend.way; i++) {
+            if (!done[i]) continue;
+            finish(message[i], lanes[i]);
+            refill(i);
+        }
+    }
+}
+
+void keccak1600_many(const void *const *messages, const size_t *lengths, size_t count, uint64_t *const *states) {
+    keccak_sponges(messages, lengths, count,
+        [&](int, size_t n) { return states[n]; },
+        [](size_t, const uint64_t *) {});
+}
+
+void cn_fast_hash(const void *data, size_t length, void *hash) {
+    uint64_t state[25];
+    keccak1600(data, length, state);
+    for (int i = 0; i < 4; i++) write_little<uint64_t>((uint8_t *)hash + 8 * i, state[i]);
+}
+
+void cn_fast_hash_many(const void *const *messages, const size_t *lengths, size_t count, void *out) {
+    uint64_t lanes[8][25];
+    keccak_sponges(messages, lengths, count,
+        [&](int lane, size_t) { return lanes[lane]; },
+        [&](size_t n, const uint64_t *state) {
+            for (int i = 0; i < 4; i++) write_little<uint64_t>((uint8_t *)out + 32 * n + 8 * i, state[i]);
+        });
+}
+
+static void keccakf_portable(uint64_t *const *states) {
+    keccakf(states[0]);
+}
+
+} // namespace hash
+
+namespace dispatch {
+namespace detail {
+
+const keccak_backend keccak_portable = {
+    "portable", nullptr, 1, &hash::keccakf_portable
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
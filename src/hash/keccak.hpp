@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <fingera/config.hpp>
+
+// Keccak-f[1600] as keccak.c keccakf(st, 24), shared by the keccak*.cpp
+// backends: one round fully unrolled over any lane type, uint64_t for one
+// state or a register holding the same lane of several states.
+namespace fingera {
+namespace hash {
+
+// keccakf(st, 24), unrolled with lane complementing (keccak.cpp)
+void keccakf(uint64_t *state);
+// count states through the fastest dispatch::keccak() backend, way at a time
+void keccakf_many(uint64_t *const *states, size_t count);
+// keccak1600: the 200 bytes state after absorbing data (136 bytes rate,
+// keccak.c's 0x01 padding)
+void keccak1600(const void *data, size_t length, uint64_t *state);
+// keccak1600 of count messages, lanes of the fastest backend refilled as
+// messages finish
+void keccak1600_many(const void *const *messages, const size_t *lengths, size_t count, uint64_t *const *states);
+
+namespace keccak {
+
+static constexpr uint64_t round_constant[24] = {
+    0x0000000000000001, 0x0000000000008082, 0x800000000000808a, 0x8000000080008000,
+    0x000000000000808b, 0x0000000080000001, 0x8000000080008081, 0x8000000000008009,
+    0x000000000000008a, 0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+    0x000000008000808b, 0x800000000000008b, 0x8000000000008089, 0x8000000000008003,
+    0x8000000000008002, 0x8000000000000080, 0x000000000000800a, 0x800000008000000a,
+    0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008,
+};
+
+// rho offset of lane x + 5y
+static constexpr int rho[25] = {
+     0,  1, 62, 28, 27,
+    36, 44,  6, 55, 20,
+     3, 10, 43, 25, 39,
+    41, 45, 15, 21,  8,
+    18,  2, 61, 56, 14,
+};
+
+// pi moves lane x + 5y to y + 5 ((2x + 3y) mod 5)
+static constexpr int pi(int i) {
+    return i / 5 + 5 * ((2 * (i % 5) + 3 * (i / 5)) % 5);
+}
+
+// One round on a[25], Lanes provides for its type:
+//   xor_(a, b), xor5(a, b, c, d, e), rotl<N>(a) with N in 0 .. 63
+//   chi<I>(a, b, c): lane I = x + 5y of chi, a ^ (~b & c) from lanes x,
+//   x + 1 and x + 2 of row y
+template<typename Lanes, int... I>
+static inline FINGERA_FORCEINLINE void round(typename Lanes::type *a, uint64_t rc, std::integer_sequence<int, I...>) {
+    using type = typename Lanes::type;
+    const type c[5] = {
+        Lanes::xor5(a[0], a[5], a[10], a[15], a[20]), Lanes::xor5(a[1], a[6], a[11], a[16], a[21]),
+        Lanes::xor5(a[2], a[7], a[12], a[17], a[22]), Lanes::xor5(a[3], a[8], a[13], a[18], a[23]),
+        Lanes::xor5(a[4], a[9], a[14], a[19], a[24]),
+    };
+    const type d[5] = {
+        Lanes::xor_(c[4], Lanes::template rotl<1>(c[1])), Lanes::xor_(c[0], Lanes::template rotl<1>(c[2])),
+        Lanes::xor_(c[1], Lanes::template rotl<1>(c[3])), Lanes::xor_(c[2], Lanes::template rotl<1>(c[4])),
+        Lanes::xor_(c[3], Lanes::template rotl<1>(c[0])),
+    };
+    // theta, rho and pi
+    type b[25];
+    int move[] = {(b[pi(I)] = Lanes::template rotl<rho[I]>(Lanes::xor_(a[I], d[I % 5])), 0)...};
+    (void)move;
+    // chi and iota
+    int store[] = {(a[I] = Lanes::template chi<I>(b[I], b[I / 5 * 5 + (I + 1) % 5], b[I / 5 * 5 + (I + 2) % 5]), 0)...};
+    (void)store;
+    a[0] = Lanes::xor_(a[0], Lanes::constant(rc));
+}
+
+// 24 rounds on lanes Lanes loaded into a[25]
+template<typename Lanes>
+static inline FINGERA_FORCEINLINE void permute(typename Lanes::type *a) {
+    for (int r = 0; r < 24; r++) round<Lanes>(a, round_constant[r], std::make_integer_sequence<int, 25>());
+}
+
+} // namespace keccak
+} // namespace hash
+} // namespace fingera
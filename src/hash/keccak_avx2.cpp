@@ -0,0 +1,80 @@
+// compiled with -mavx2 (CMakeLists.txt)
+#include <cstdint>
+#include <fingera/config.hpp>
+#include "backends.hpp"
+#include "keccak.hpp"
+#include <immintrin.h>
+
+namespace fingera {
+namespace hash {
+
+// Four states at once, register i holding lane i of each. AVX2 has
+// ANDNOT, so chi needs no lane complementing.
+struct keccak_avx2 {
+    using type = __m256i;
+
+    static inline FINGERA_FORCEINLINE __m256i xor_(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+    static inline FINGERA_FORCEINLINE __m256i xor5(__m256i a, __m256i b, __m256i c, __m256i d, __m256i e) {
+        return _mm256_xor_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(_mm256_xor_si256(c, d), e));
+    }
+    // byte rotations by one shuffle
+    template<int N>
+    static inline FINGERA_FORCEINLINE __m256i rotl(__m256i x) {
+        const __m256i rotl8 = _mm256_set_epi8(14, 13, 12, 11, 10, 9, 8, 15, 6, 5, 4, 3, 2, 1, 0, 7,
+            14, 13, 12, 11, 10, 9, 8, 15, 6, 5, 4, 3, 2, 1, 0, 7);
+        const __m256i rotl56 = _mm256_set_epi8(8, 15, 14, 13, 12, 11, 10, 9, 0, 7, 6, 5, 4, 3, 2, 1,
+            8, 15, 14, 13, 12, 11, 10, 9, 0, 7, 6, 5, 4, 3, 2, 1);
+        if (N == 0) return x;
+        if (N == 8) return _mm256_shuffle_epi8(x, rotl8);
+        if (N == 56) return _mm256_shuffle_epi8(x, rotl56);
+        return _mm256_or_si256(_mm256_slli_epi64(x, N), _mm256_srli_epi64(x, 64 - N));
+    }
+    template<int I>
+    static inline FINGERA_FORCEINLINE __m256i chi(__m256i a, __m256i b, __m256i c) {
+        return _mm256_xor_si256(a, _mm256_andnot_si256(b, c));
+    }
+    static inline FINGERA_FORCEINLINE __m256i constant(uint64_t rc) { return _mm256_set1_epi64x((long long)rc); }
+};
+
+// 4x4 transpose of 64 bit words, rows to columns and back
+static inline FINGERA_FORCEINLINE void keccak_transpose(__m256i &r0, __m256i &r1, __m256i &r2, __m256i &r3) {
+    const __m256i t0 = _mm256_unpacklo_epi64(r0, r1), t1 = _mm256_unpackhi_epi64(r0, r1);
+    const __m256i t2 = _mm256_unpacklo_epi64(r2, r3), t3 = _mm256_unpackhi_epi64(r2, r3);
+    r0 = _mm256_permute2x128_si256(t0, t2, 0x20);
+    r1 = _mm256_permute2x128_si256(t1, t3, 0x20);
+    r2 = _mm256_permute2x128_si256(t0, t2, 0x31);
+    r3 = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+static void keccakf_avx2(uint64_t *const *states) {
+    __m256i a[25];
+    for (int i = 0; i < 24; i += 4) {
+        for (int k = 0; k < 4; k++) a[i + k] = _mm256_loadu_si256((const __m256i *)(states[k] + i));
+        keccak_transpose(a[i], a[i + 1], a[i + 2], a[i + 3]);
+    }
+    a[24] = _mm256_set_epi64x((long long)states[3][24], (long long)states[2][24], (long long)states[1][24],
+        (long long)states[0][24]);
+
+    keccak::permute<keccak_avx2>(a);
+
+    for (int i = 0; i < 24; i += 4) {
+        keccak_transpose(a[i], a[i + 1], a[i + 2], a[i + 3]);
+        for (int k = 0; k < 4; k++) _mm256_storeu_si256((__m256i *)(states[k] + i), a[i + k]);
+    }
+    alignas(32) uint64_t last[4];
+    _mm256_store_si256((__m256i *)last, a[24]);
+    for (int k = 0; k < 4; k++) states[k][24] = last[k];
+}
+
+} // namespace hash
+
+namespace dispatch {
+namespace detail {
+
+const keccak_backend keccak_avx2 = {
+    "avx2", "avx2", 4, &hash::keccakf_avx2
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
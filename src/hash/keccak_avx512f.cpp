@@ -0,0 +1,57 @@
+// compiled with -mavx512f (CMakeLists.txt)
+#include <cstdint>
+#include <fingera/config.hpp>
+#include "backends.hpp"
+#include "keccak.hpp"
+#include <immintrin.h>
+
+namespace fingera {
+namespace hash {
+
+// Eight states at once, register i holding lane i of each: rotations are
+// VPROLQ, the five way xors of theta two VPTERNLOGQ and chi one.
+struct keccak_avx512f {
+    using type = __m512i;
+
+    static inline FINGERA_FORCEINLINE __m512i xor_(__m512i a, __m512i b) { return _mm512_xor_si512(a, b); }
+    static inline FINGERA_FORCEINLINE __m512i xor5(__m512i a, __m512i b, __m512i c, __m512i d, __m512i e) {
+        return _mm512_ternarylogic_epi64(_mm512_ternarylogic_epi64(a, b, c, 0x96), d, e, 0x96);
+    }
+    template<int N>
+    static inline FINGERA_FORCEINLINE __m512i rotl(__m512i x) { return N ? _mm512_rol_epi64(x, N) : x; }
+    // a ^ (~b & c)
+    template<int I>
+    static inline FINGERA_FORCEINLINE __m512i chi(__m512i a, __m512i b, __m512i c) {
+        return _mm512_ternarylogic_epi64(a, b, c, 0xd2);
+    }
+    static inline FINGERA_FORCEINLINE __m512i constant(uint64_t rc) { return _mm512_set1_epi64((long long)rc); }
+};
+
+static void keccakf_avx512f(uint64_t *const *states) {
+    // lane i of the eight states: gathered by address, states aren't
+    // evenly spaced
+    const __m512i address = _mm512_loadu_si512((const void *)states);
+    __m512i a[25];
+    for (int i = 0; i < 25; i++) {
+        a[i] = _mm512_i64gather_epi64(_mm512_add_epi64(address, _mm512_set1_epi64(8 * i)), nullptr, 1);
+    }
+
+    keccak::permute<keccak_avx512f>(a);
+
+    for (int i = 0; i < 25; i++) {
+        _mm512_i64scatter_epi64(nullptr, _mm512_add_epi64(address, _mm512_set1_epi64(8 * i)), a[i], 1);
+    }
+}
+
+} // namespace hash
+
+namespace dispatch {
+namespace detail {
+
+const keccak_backend keccak_avx512f = {
+    "avx512f", "avx512f", 8, &hash::keccakf_avx512f
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
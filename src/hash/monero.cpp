@@ -1,275 +1,360 @@
 #include <cassert>
 #include <cstdint>
-#include <iostream>
-#include <fingera/hex.hpp>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fingera/endian.hpp>
 #include <fingera/hash/monero.hpp>
+#include <fingera/hugepages.hpp>
+#include <fingera/dispatch.hpp>
 #include <fingera/config.hpp>
+#include "backends.hpp"
+#include "cryptonight.hpp"
+#include "keccak.hpp"
 extern "C" {
 #include "monero/hash-ops.h"
-#include "monero/keccak.h"
+#include "monero/common/int-util.h"
+extern void aesb_single_round(const uint8_t *in, uint8_t *out, uint8_t *expandedKey);
+extern void aesb_pseudo_round(const uint8_t *in, uint8_t *out, uint8_t *expandedKey);
+extern void aesb_expand_key(const uint8_t *key, uint8_t *expandedKey);
 }
-#include <immintrin.h>
-
-static void (*const extra_hashes[4])(const void *, size_t, char *) = {
-    hash_extra_blake, hash_extra_groestl, hash_extra_jh, hash_extra_skein
-};
 
 namespace fingera {
 namespace hash {
-    
+
+// floor(2 * sqrt(2^64 + n)) - 2^33, one result bit per step
+static inline uint64_t integer_square_root_v2(uint64_t n) {
+    uint64_t r = 1ULL << 63;
+    for (uint64_t bit = 1ULL << 60; bit; bit >>= 2) {
+        const bool b = n < r + bit;
+        const uint64_t n_next = n - (r + bit);
+        const uint64_t r_next = r + bit * 2;
+        n = b ? n : n_next;
+        r = b ? r : r_next;
+        r >>= 1;
+    }
+    return r * 2 + (n > r ? 1 : 0);
+}
+
+// variant 2: the three other 16 bytes lines of the 64 bytes around offset
+// are rotated, each plus one of b1, b, a. Variant 4 also xors the old lines
+// into c.
+template<int Variant>
+static inline void shuffle_add_v2(uint8_t *l, size_t offset, const uint64_t *a, const uint64_t *b, const uint64_t *b1,
+        uint64_t *c) {
+    uint64_t *chunk1 = (uint64_t *)&l[offset ^ 0x10];
+    uint64_t *chunk2 = (uint64_t *)&l[offset ^ 0x20];
+    uint64_t *chunk3 = (uint64_t *)&l[offset ^ 0x30];
+    const uint64_t c1[2] = {chunk1[0], chunk1[1]};
+    const uint64_t c2[2] = {chunk2[0], chunk2[1]};
+    const uint64_t c3[2] = {chunk3[0], chunk3[1]};
+    chunk1[0] = c3[0] + b1[0];
+    chunk1[1] = c3[1] + b1[1];
+    chunk2[0] = c1[0] + b[0];
+    chunk2[1] = c1[1] + b[1];
+    chunk3[0] = c2[0] + a[0];
+    chunk3[1] = c2[1] + a[1];
+    if (Variant == 4) {
+        c[0] ^= c1[0] ^ c2[0] ^ c3[0];
+        c[1] ^= c1[1] ^ c2[1] ^ c3[1];
+    }
+}
+
+// Software AES (aesb.c), the same steps as cn_slow_hash
+// without AES-NI, one hash at a time. Also the reference for variant 2 and
+// 4, which this cn_slow_hash does not implement.
+template<typename Algo>
+static void cn_hash_portable(const void *blob, size_t length, void *result, void *scratchpad,
+        const cryptonight_r_program *program) {
+    assert(Algo::variant != 1 || length >= 43); // the tweak reads the nonce
+    uint8_t *l = (uint8_t *)scratchpad;
+    uint64_t h[25];
+    keccak1600(blob, length, h);
+    const uint64_t tweak1_2 = Algo::variant == 1 ? h[24] ^ *((const uint64_t *)((const char *)blob + 35)) : 0;
+
+    uint8_t text[128];
+    memcpy(text, &h[8], sizeof(text));
+    uint8_t key[240];
+    aesb_expand_key((const uint8_t *)&h[0], key);
+    for (size_t i = 0; i < Algo::memory; i += sizeof(text)) {
+        for (size_t j = 0; j < sizeof(text); j += 16) {
+            aesb_pseudo_round(&text[j], &text[j], key);
+        }
+        memcpy(&l[i], text, sizeof(text));
+    }
+
+    uint64_t a[2] = {h[0] ^ h[4], h[1] ^ h[5]};
+    uint64_t b[2] = {h[2] ^ h[6], h[3] ^ h[7]};
+    uint64_t b1[2] = {h[8] ^ h[10], h[9] ^ h[11]};
+    uint64_t division_result = h[12];
+    uint64_t sqrt_result = h[13];
+    uint32_t r[9];
+    memcpy(r, &h[12], 4 * sizeof(uint32_t));
+    for (size_t i = 0; i < Algo::iterations; i++) {
+        uint64_t *m = (uint64_t *)&l[a[0] & Algo::mask];
+        uint64_t c[2] = {m[0], m[1]};
+        aesb_single_round((const uint8_t *)c, (uint8_t *)c, (uint8_t *)a);
+        if (Algo::variant >= 2) shuffle_add_v2<Algo::variant>(l, a[0] & Algo::mask, a, b, b1, c);
+        uint64_t vh = b[1] ^ c[1];
+        if (Algo::variant == 1) {
+            uint8_t x = vh >> 24;
+            static const uint16_t table = 0x7531;
+            const uint8_t index = (((x >> 3) & 6) | (x & 1)) << 1;
+            vh ^= ((table >> index) & 0x3) << 28;
+        }
+        m[0] = b[0] ^ c[0];
+        m[1] = vh;
+
+        m = (uint64_t *)&l[c[0] & Algo::mask];
+        uint64_t d[2] = {m[0], m[1]};
+        if (Algo::variant == 2) {
+            d[0] ^= division_result ^ (sqrt_result << 32);
+            const uint64_t dividend = c[1];
+            const uint32_t divisor = (c[0] + (uint32_t)(sqrt_result << 1)) | 0x80000001UL;
+            division_result = (uint32_t)(dividend / divisor) + ((dividend % divisor) << 32);
+            sqrt_result = integer_square_root_v2(c[0] + division_result);
+        }
+        const uint64_t a0[2] = {a[0], a[1]};
+        if (Algo::variant == 4) {
+            d[0] ^= (r[0] + r[1]) | ((uint64_t)(r[2] + r[3]) << 32);
+            r[4] = (uint32_t)a[0];
+            r[5] = (uint32_t)a[1];
+            r[6] = (uint32_t)b[0];
+            r[7] = (uint32_t)b1[0];
+            r[8] = (uint32_t)b1[1];
+            cn::r_run(*program, r);
+            a[0] ^= r[2] | ((uint64_t)r[3] << 32);
+            a[1] ^= r[0] | ((uint64_t)r[1] << 32);
+        }
+        uint64_t hi;
+        uint64_t lo = mul128(c[0], d[0], &hi);
+        if (Algo::variant == 2) {
+            uint64_t *chunk1 = (uint64_t *)&l[(c[0] & Algo::mask) ^ 0x10];
+            const uint64_t *chunk2 = (const uint64_t *)&l[(c[0] & Algo::mask) ^ 0x20];
+            chunk1[0] ^= hi;
+            chunk1[1] ^= lo;
+            hi ^= chunk2[0];
+            lo ^= chunk2[1];
+        }
+        if (Algo::variant >= 2) shuffle_add_v2<Algo::variant>(l, c[0] & Algo::mask, a0, b, b1, c);
+        b1[0] = b[0];
+        b1[1] = b[1];
+        b[0] = c[0];
+        b[1] = c[1];
+        a[0] += hi;
+        a[1] += lo;
+        m[0] = a[0];
+        m[1] = a[1] ^ tweak1_2;
+        a[0] ^= d[0];
+        a[1] ^= d[1];
+    }
+
+    memcpy(text, &h[8], sizeof(text));
+    aesb_expand_key((const uint8_t *)&h[4], key);
+    for (size_t i = 0; i < Algo::memory; i += sizeof(text)) {
+        for (size_t j = 0; j < sizeof(text); j += 16) {
+            for (size_t k = 0; k < 16; k++) {
+                text[j + k] ^= l[i + j + k];
+            }
+            aesb_pseudo_round(&text[j], &text[j], key);
+        }
+    }
+    memcpy(&h[8], text, sizeof(text));
+
+    keccakf(h);
+    dispatch::monero_extra()[h[0] & 3](h, 200, (char *)result);
+}
+
+template<typename Algo>
+static void cn_kernel_portable(const void *blob, size_t length, void *result, void *scratchpad) {
+    cn_hash_portable<Algo>(blob, length, result, scratchpad, nullptr);
+}
+
+static void cn_r_portable(const void *blob, size_t length, void *result, void *scratchpad,
+        const cryptonight_r_program &program) {
+    cn_hash_portable<cn::r>(blob, length, result, scratchpad, &program);
+}
+
+template<typename Algo, int N>
+static void cn_kernel_multi_portable(const void *const *blobs, const size_t *lengths, void *const *results,
+        void *scratchpad) {
+    for (int n = 0; n < N; n++) {
+        cn_kernel_portable<Algo>(blobs[n], lengths[n], results[n], (uint8_t *)scratchpad + n * Algo::memory);
+    }
+}
+
+template<typename Algo>
+static constexpr dispatch::cryptonight_kernel make_kernel_portable(const char *algorithm) {
+    return {algorithm, Algo::memory, &cn_kernel_portable<Algo>, {
+        &cn_kernel_multi_portable<Algo, 1>,
+        &cn_kernel_multi_portable<Algo, 2>,
+        &cn_kernel_multi_portable<Algo, 3>,
+        &cn_kernel_multi_portable<Algo, 4>,
+        &cn_kernel_multi_portable<Algo, 5>,
+    }};
+}
+
+static constexpr dispatch::cryptonight_kernel kernels_portable[] = {
+    make_kernel_portable<cn::v1>("cn/1"),
+    make_kernel_portable<cn::v0>("cn/0"),
+    make_kernel_portable<cn::msr>("cn/msr"),
+    make_kernel_portable<cn::v2>("cn/2"),
+    make_kernel_portable<cn::half>("cn/half"),
+    make_kernel_portable<cn::lite_v1>("cn-lite/1"),
+    make_kernel_portable<cn::lite_v0>("cn-lite/0"),
+};
+
+// bytes, kept for the life of the thread
+static void *thread_scratchpad(size_t size) {
+    static thread_local hugepage_buffer scratchpad;
+    if (scratchpad.size() < size) {
+        scratchpad = hugepage_buffer(size);
+    }
+    return scratchpad.data();
+}
+
 void monero_standard(const void *data, size_t length, void *result) {
     assert(length != 0);
     uint8_t major_version = *(const uint8_t *)data;
-    assert(major_version <= 127); // now 7
+    assert(major_version <= 127); // now 8
 
     const int cn_variant = major_version >= 7 ? major_version - 6 : 0;
+    if (cn_variant >= 2) {
+        cn_kernel_portable<cn::v2>(data, length, result, thread_scratchpad(cn::v2::memory));
+        return;
+    }
     cn_slow_hash(data, length, (char *)result, cn_variant, 0);
 }
 
-// This will shift and xor tmp1 into itself as 4 32-bit vals such as
-// sl_xor(a1 a2 a3 a4) = a1 (a2^a1) (a3^a2^a1) (a4^a3^a2^a1)
-inline __m128i sl_xor(__m128i tmp1) {
-    __m128i tmp4;
-    tmp4 = _mm_slli_si128(tmp1, 0x04);
-    tmp1 = _mm_xor_si128(tmp1, tmp4);
-    tmp4 = _mm_slli_si128(tmp4, 0x04);
-    tmp1 = _mm_xor_si128(tmp1, tmp4);
-    tmp4 = _mm_slli_si128(tmp4, 0x04);
-    tmp1 = _mm_xor_si128(tmp1, tmp4);
-    return tmp1;
+void monero_cpu_fast(const void *block_blob, size_t length, void *result) {
+    monero_cpu_fast(block_blob, length, result, thread_scratchpad(monero_scratchpad_size));
 }
 
-template<uint8_t rcon>
-inline void aes_genkey_sub(__m128i* xout0, __m128i* xout2) {
-    __m128i xout1 = _mm_aeskeygenassist_si128(*xout2, rcon);
-    xout1  = _mm_shuffle_epi32(xout1, 0xFF); // see PSHUFD, set all elems to 4th elem
-    *xout0 = sl_xor(*xout0);
-    *xout0 = _mm_xor_si128(*xout0, xout1);
-    xout1  = _mm_aeskeygenassist_si128(*xout0, 0x00);
-    xout1  = _mm_shuffle_epi32(xout1, 0xAA); // see PSHUFD, set all elems to 3rd elem
-    *xout2 = sl_xor(*xout2);
-    *xout2 = _mm_xor_si128(*xout2, xout1);
+void monero_cpu_fast(const void *block_blob, size_t length, void *result, void *scratchpad) {
+    dispatch::monero().cpu_fast(block_blob, length, result, scratchpad);
 }
 
-inline void aes_expand_key(const __m128i* memory, __m128i* k0, __m128i* k1, __m128i* k2, __m128i* k3, __m128i* k4, __m128i* k5, __m128i* k6, __m128i* k7, __m128i* k8, __m128i* k9) {
-    __m128i xout0 = _mm_load_si128(memory);
-    __m128i xout2 = _mm_load_si128(memory + 1);
-    *k0 = xout0;
-    *k1 = xout2;
-
-    aes_genkey_sub<0x01>(&xout0, &xout2);
-    *k2 = xout0;
-    *k3 = xout2;
+template<int N>
+void monero_cpu_fast_multi(const void *const (&block_blobs)[N], const size_t (&lengths)[N], void *const (&results)[N]) {
+    monero_cpu_fast_multi<N>(block_blobs, lengths, results, thread_scratchpad(monero_scratchpad_size * N));
+}
 
-    aes_genkey_sub<0x02>(&xout0, &xout2);
-    *k4 = xout0;
-    *k5 = xout2;
+template<int N>
+void monero_cpu_fast_multi(const void *const (&block_blobs)[N], const size_t (&lengths)[N], void *const (&results)[N],
+        void *scratchpad) {
+    static_assert(N >= 1 && N <= 5, "1 .. 5 hashes");
+    dispatch::monero().cpu_fast_multi[N - 1](block_blobs, lengths, results, scratchpad);
+}
+template void monero_cpu_fast_multi<1>(const void *const (&)[1], const size_t (&)[1], void *const (&)[1]);
+template void monero_cpu_fast_multi<2>(const void *const (&)[2], const size_t (&)[2], void *const (&)[2]);
+template void monero_cpu_fast_multi<3>(const void *const (&)[3], const size_t (&)[3], void *const (&)[3]);
+template void monero_cpu_fast_multi<4>(const void *const (&)[4], const size_t (&)[4], void *const (&)[4]);
+template void monero_cpu_fast_multi<5>(const void *const (&)[5], const size_t (&)[5], void *const (&)[5]);
+template void monero_cpu_fast_multi<1>(const void *const (&)[1], const size_t (&)[1], void *const (&)[1], void *);
+template void monero_cpu_fast_multi<2>(const void *const (&)[2], const size_t (&)[2], void *const (&)[2], void *);
+template void monero_cpu_fast_multi<3>(const void *const (&)[3], const size_t (&)[3], void *const (&)[3], void *);
+template void monero_cpu_fast_multi<4>(const void *const (&)[4], const size_t (&)[4], void *const (&)[4], void *);
+template void monero_cpu_fast_multi<5>(const void *const (&)[5], const size_t (&)[5], void *const (&)[5], void *);
+
+static const dispatch::cryptonight_kernel &find_kernel(const char *algorithm) {
+    const dispatch::cryptonight_kernel *kernel = dispatch::cryptonight(algorithm);
+    if (!kernel) throw std::invalid_argument(std::string("unknown cryptonight algorithm ") + algorithm);
+    return *kernel;
+}
 
-    aes_genkey_sub<0x04>(&xout0, &xout2);
-    *k6 = xout0;
-    *k7 = xout2;
+size_t cryptonight_memory(const char *algorithm) {
+    const dispatch::cryptonight_kernel *kernel = dispatch::cryptonight(algorithm);
+    return kernel ? kernel->memory : 0;
+}
 
-    aes_genkey_sub<0x08>(&xout0, &xout2);
-    *k8 = xout0;
-    *k9 = xout2;
+void cryptonight(const char *algorithm, const void *blob, size_t length, void *result) {
+    const dispatch::cryptonight_kernel &kernel = find_kernel(algorithm);
+    kernel.hash(blob, length, result, thread_scratchpad(kernel.memory));
 }
 
-inline void aes_round(__m128i key, __m128i* x0, __m128i* x1, __m128i* x2, __m128i* x3, __m128i* x4, __m128i* x5, __m128i* x6, __m128i* x7) {
-    *x0 = _mm_aesenc_si128(*x0, key);
-    *x1 = _mm_aesenc_si128(*x1, key);
-    *x2 = _mm_aesenc_si128(*x2, key);
-    *x3 = _mm_aesenc_si128(*x3, key);
-    *x4 = _mm_aesenc_si128(*x4, key);
-    *x5 = _mm_aesenc_si128(*x5, key);
-    *x6 = _mm_aesenc_si128(*x6, key);
-    *x7 = _mm_aesenc_si128(*x7, key);
+void cryptonight(const char *algorithm, const void *blob, size_t length, void *result, void *scratchpad) {
+    find_kernel(algorithm).hash(blob, length, result, scratchpad);
 }
 
-#define MEMORY         (1 << 21) // 2MB scratchpad
-#define ITERATIONS      (1 << 19)
-inline void cn_explode_scratchpad(const __m128i *input, __m128i *output) {
-    __m128i k0, k1, k2, k3, k4, k5, k6, k7, k8, k9;
-    aes_expand_key(input, &k0, &k1, &k2, &k3, &k4, &k5, &k6, &k7, &k8, &k9);
-
-    __m128i xin0, xin1, xin2, xin3, xin4, xin5, xin6, xin7;
-    xin0 = _mm_load_si128(input + 4);
-    xin1 = _mm_load_si128(input + 5);
-    xin2 = _mm_load_si128(input + 6);
-    xin3 = _mm_load_si128(input + 7);
-    xin4 = _mm_load_si128(input + 8);
-    xin5 = _mm_load_si128(input + 9);
-    xin6 = _mm_load_si128(input + 10);
-    xin7 = _mm_load_si128(input + 11);
-
-    for (size_t i = 0; i < MEMORY / 16; i += 8) {
-        aes_round(k0, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-        aes_round(k1, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-        aes_round(k2, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-        aes_round(k3, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-        aes_round(k4, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-        aes_round(k5, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-        aes_round(k6, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-        aes_round(k7, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-        aes_round(k8, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-        aes_round(k9, &xin0, &xin1, &xin2, &xin3, &xin4, &xin5, &xin6, &xin7);
-
-        _mm_store_si128(output + i + 0, xin0);
-        _mm_store_si128(output + i + 1, xin1);
-        _mm_store_si128(output + i + 2, xin2);
-        _mm_store_si128(output + i + 3, xin3);
-        _mm_store_si128(output + i + 4, xin4);
-        _mm_store_si128(output + i + 5, xin5);
-        _mm_store_si128(output + i + 6, xin6);
-        _mm_store_si128(output + i + 7, xin7);
-    }
+uint64_t cryptonight_scan(const char *algorithm, const void *blob, size_t length, uint64_t nonce_begin,
+        uint64_t nonce_end, uint64_t target64, const cryptonight_share &on_share, int ways) {
+    const dispatch::cryptonight_kernel &kernel = find_kernel(algorithm);
+    if (ways < 1 || ways > 5) throw std::invalid_argument("cryptonight_scan: ways out of 1 .. 5");
+    // not thread_scratchpad: on_share may hash and grow it under the scan
+    hugepage_buffer scratchpad(kernel.memory * ways);
+    return cryptonight_scan(algorithm, blob, length, nonce_begin, nonce_end, target64, on_share, ways,
+        scratchpad.data());
 }
 
-static inline void cn_implode_scratchpad(const __m128i *input, __m128i *output)
-{
-    __m128i xout0, xout1, xout2, xout3, xout4, xout5, xout6, xout7;
-    __m128i k0, k1, k2, k3, k4, k5, k6, k7, k8, k9;
-
-    aes_expand_key(output + 2, &k0, &k1, &k2, &k3, &k4, &k5, &k6, &k7, &k8, &k9);
-
-    xout0 = _mm_load_si128(output + 4);
-    xout1 = _mm_load_si128(output + 5);
-    xout2 = _mm_load_si128(output + 6);
-    xout3 = _mm_load_si128(output + 7);
-    xout4 = _mm_load_si128(output + 8);
-    xout5 = _mm_load_si128(output + 9);
-    xout6 = _mm_load_si128(output + 10);
-    xout7 = _mm_load_si128(output + 11);
-
-    for (size_t i = 0; i < MEMORY / 16; i += 8)
-    {
-        xout0 = _mm_xor_si128(_mm_load_si128(input + i + 0), xout0);
-        xout1 = _mm_xor_si128(_mm_load_si128(input + i + 1), xout1);
-        xout2 = _mm_xor_si128(_mm_load_si128(input + i + 2), xout2);
-        xout3 = _mm_xor_si128(_mm_load_si128(input + i + 3), xout3);
-        xout4 = _mm_xor_si128(_mm_load_si128(input + i + 4), xout4);
-        xout5 = _mm_xor_si128(_mm_load_si128(input + i + 5), xout5);
-        xout6 = _mm_xor_si128(_mm_load_si128(input + i + 6), xout6);
-        xout7 = _mm_xor_si128(_mm_load_si128(input + i + 7), xout7);
-
-        aes_round(k0, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
-        aes_round(k1, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
-        aes_round(k2, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
-        aes_round(k3, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
-        aes_round(k4, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
-        aes_round(k5, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
-        aes_round(k6, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
-        aes_round(k7, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
-        aes_round(k8, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
-        aes_round(k9, &xout0, &xout1, &xout2, &xout3, &xout4, &xout5, &xout6, &xout7);
+uint64_t cryptonight_scan(const char *algorithm, const void *blob, size_t length, uint64_t nonce_begin,
+        uint64_t nonce_end, uint64_t target64, const cryptonight_share &on_share, int ways, void *scratchpad) {
+    const dispatch::cryptonight_kernel &kernel = find_kernel(algorithm);
+    if (length < 43) throw std::invalid_argument("cryptonight_scan: blob shorter than 43 bytes");
+    if (nonce_end > ((uint64_t)1 << 32)) throw std::invalid_argument("cryptonight_scan: nonce_end past 2^32");
+    if (ways < 1 || ways > 5) throw std::invalid_argument("cryptonight_scan: ways out of 1 .. 5");
+
+    // one blob per way, only their nonces change
+    std::vector<uint8_t> blobs(length * ways);
+    const void *lanes[5];
+    size_t lengths[5];
+    uint8_t hashes[5][32];
+    void *results[5];
+    for (int i = 0; i < ways; i++) {
+        memcpy(&blobs[length * i], blob, length);
+        lanes[i] = &blobs[length * i];
+        lengths[i] = length;
+        results[i] = hashes[i];
     }
 
-    _mm_store_si128(output + 4, xout0);
-    _mm_store_si128(output + 5, xout1);
-    _mm_store_si128(output + 6, xout2);
-    _mm_store_si128(output + 7, xout3);
-    _mm_store_si128(output + 8, xout4);
-    _mm_store_si128(output + 9, xout5);
-    _mm_store_si128(output + 10, xout6);
-    _mm_store_si128(output + 11, xout7);
-}
-
-void monero_cpu_fast(const void *block_blob, size_t length, void *result) {
-    // major_version 1-2 current 1
-    // minor_version 1-2 current 1
-    // timestamp 1-10 current min 5()
-    // prev_id 32
-    // nonce 4
-    // tree_root_hash 32
-    // (tx_hashes.size()+1) 1-10
-    // 0-126 tx: 76
-    // 127-254 tx: 77
-    // accept: 76->80
-    assert(length >= 76 && length <= 80);
-    assert(*(const uint8_t *)block_blob == 7); // accept: major_version = 7
-
-    alignas(16) uint8_t keccak_state[200];
-    alignas(256) uint8_t memory[MEMORY];
-
-    /* CryptoNight Step 1:  Use Keccak1600 to initialize the 'state' (and 'text') buffers from the data. */
-    keccak1600((const uint8_t *)block_blob, length, keccak_state);
-
-    uint64_t tweak1_2_0 = ((uint64_t *)keccak_state)[24] ^ *((uint64_t *)((char *)block_blob + 35));
-
-    cn_explode_scratchpad((__m128i*)keccak_state, (__m128i*)memory);
-
-    const uint8_t* l0 = memory;
-    uint64_t* h0 = reinterpret_cast<uint64_t*>(keccak_state);
-
-    uint64_t al0 = h0[0] ^ h0[4];
-    uint64_t ah0 = h0[1] ^ h0[5];
-    __m128i bx0 = _mm_set_epi64x(h0[3] ^ h0[7], h0[2] ^ h0[6]);
-
-/*
-    FILE *fp = fopen("/tmp/mmmmmm_cpu_fast", "wb");
-    fwrite(memory, MEMORY, 1, fp);
-    fclose(fp);
-*/
-    // std::cout << al0 << ", " << ah0 << ", " << (h0[2] ^ h0[6]) << ", " << (h0[3] ^ h0[7]) << ", " << tweak1_2_0 << std::endl;
-
-    uint64_t idx0 = al0;
-    for (size_t i = 0; i < ITERATIONS; i++) {
-        const void *m = &l0[idx0 & 0x1FFFF0];
-        // _mm_prefetch(m, _MM_HINT_NTA);
-        __m128i cx = _mm_load_si128((__m128i *) m);
-        cx = _mm_aesenc_si128(cx, _mm_set_epi64x(ah0, al0));
-
-        __m128i tmp = _mm_xor_si128(bx0, cx);
-        ((uint64_t *)m)[0] = _mm_cvtsi128_si64(tmp);
-
-        tmp = _mm_castps_si128(_mm_movehl_ps(_mm_castsi128_ps(tmp), _mm_castsi128_ps(tmp)));
-        uint64_t vh = _mm_cvtsi128_si64(tmp);
-        uint8_t x = vh >> 24;
-        static const uint16_t table = 0x7531;
-        const uint8_t index = (((x >> 3) & 6) | (x & 1)) << 1;
-        vh ^= ((table >> index) & 0x3) << 28;
-        ((uint64_t *)m)[1] = vh;
-
-        idx0 = _mm_cvtsi128_si64(cx);
-        m = &l0[idx0 & 0x1FFFF0];
-        // _mm_prefetch(m, _MM_HINT_NTA);
-        bx0 = cx;
-
-        uint64_t hi, lo, cl, ch;
-        cl = ((uint64_t*) m)[0];
-        ch = ((uint64_t*) m)[1];
-        lo = _mulx_u64(idx0, cl, (unsigned long long *)&hi);
-
-        al0 += hi;
-        ah0 += lo;
-
-        ((uint64_t*) m)[0] = al0;
-        ((uint64_t*) m)[1] = ah0 ^ tweak1_2_0;
-
-        al0 ^= cl;
-        ah0 ^= ch;
-        idx0 = al0;
-/*
-        if (i == 0) {
-    FILE *fp = fopen("/tmp/mmmmmm_cpu_fast", "wb");
-    fwrite(memory, MEMORY, 1, fp);
-    fclose(fp);
-            std::cout << al0 << ", " << ah0 << std::endl;
+    uint64_t shares = 0;
+    for (uint64_t nonce = nonce_begin; nonce < nonce_end; nonce += ways) {
+        const int n = nonce_end - nonce < (uint64_t)ways ? (int)(nonce_end - nonce) : ways;
+        for (int i = 0; i < n; i++) {
+            write_little<uint32_t>(&blobs[length * i + 39], (uint32_t)nonce + i);
+        }
+        kernel.hash_multi[n - 1](lanes, lengths, results, scratchpad);
+        for (int i = 0; i < n; i++) {
+            if (read_little<uint64_t>(hashes[i] + 24) < target64) {
+                shares++;
+                on_share((uint32_t)nonce + i, hashes[i]);
+            }
         }
-*/
     }
+    return shares;
+}
 
-    cn_implode_scratchpad((__m128i*) memory, (__m128i*) h0);
+void cryptonight_r(const cryptonight_r_program &program, const void *blob, size_t length, void *result) {
+    cryptonight_r(program, blob, length, result, thread_scratchpad(cn::r::memory));
+}
 
-/*
-    for (size_t i = 0; i < 25; i++) {
-        std::cout << h0[i] << ", ";
-        if (i && (i % 5) == 0) std::cout << std::endl;
-    }
-    std::cout << std::endl;
-*/
-    keccakf(h0, 24);
-    extra_hashes[h0[0] & 3](h0, 200, (char *)result);
+void cryptonight_r(const cryptonight_r_program &program, const void *blob, size_t length, void *result,
+        void *scratchpad) {
+    dispatch::monero().cn_r(blob, length, result, scratchpad, program);
 }
 
 } // namespace hash
-} // namespace fingera
\ No newline at end of file
+
+namespace dispatch {
+namespace detail {
+
+const monero_backend monero_portable = {
+    "portable", nullptr, &hash::cn_kernel_portable<hash::cn::v1>, {
+        &hash::cn_kernel_multi_portable<hash::cn::v1, 1>,
+        &hash::cn_kernel_multi_portable<hash::cn::v1, 2>,
+        &hash::cn_kernel_multi_portable<hash::cn::v1, 3>,
+        &hash::cn_kernel_multi_portable<hash::cn::v1, 4>,
+        &hash::cn_kernel_multi_portable<hash::cn::v1, 5>,
+    },
+    hash::kernels_portable, sizeof(hash::kernels_portable) / sizeof(hash::kernels_portable[0]),
+    &hash::cn_r_portable
+};
+
+// the reference code, every finalizer
+const monero_extra_backend monero_extra_portable = {
+    "portable", nullptr, {hash_extra_blake, hash_extra_groestl, hash_extra_jh, hash_extra_skein}
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
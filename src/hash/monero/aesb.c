@@ -179,6 +179,43 @@ STATIC INLINE void aesb_pseudo_round(const uint8_t *in, uint8_t *out, uint8_t *e
   state_out(out, b0);
 }
 
+/* AES-256 key schedule (FIPS-197 5.2) into 240 bytes, the layout of
+ * oaes_key_import_data's exp_data, without allocating an oaes_ctx. */
+void aesb_expand_key(const uint8_t *key, uint8_t *expandedKey)
+{
+  static const uint8_t sbox[256] = sb_data(h0);
+  uint8_t rcon = 1;
+  int i;
+
+  for(i = 0; i < 32; i++)
+    expandedKey[i] = key[i];
+  for(i = 32; i < 240; i += 4)
+  {
+    uint8_t t0 = expandedKey[i - 4], t1 = expandedKey[i - 3], t2 = expandedKey[i - 2], t3 = expandedKey[i - 1];
+    if(i % 32 == 0)
+    {
+      /* RotWord, SubWord, Rcon */
+      const uint8_t r = t0;
+      t0 = sbox[t1] ^ rcon;
+      t1 = sbox[t2];
+      t2 = sbox[t3];
+      t3 = sbox[r];
+      rcon = (uint8_t)((rcon << 1) ^ ((rcon >> 7) * 0x1b));
+    }
+    else if(i % 32 == 16)
+    {
+      t0 = sbox[t0];
+      t1 = sbox[t1];
+      t2 = sbox[t2];
+      t3 = sbox[t3];
+    }
+    expandedKey[i + 0] = expandedKey[i - 32] ^ t0;
+    expandedKey[i + 1] = expandedKey[i - 31] ^ t1;
+    expandedKey[i + 2] = expandedKey[i - 30] ^ t2;
+    expandedKey[i + 3] = expandedKey[i - 29] ^ t3;
+  }
+}
+
 
 #if defined(__cplusplus)
 }
@@ -0,0 +1,39 @@
+// compiled with -maes (CMakeLists.txt)
+#include "backends.hpp"
+#include "cryptonight_aesni.hpp"
+
+namespace fingera {
+namespace hash {
+
+using aesni = cn_scratchpad_aes<cn_aes_hw>;
+
+static constexpr dispatch::cryptonight_kernel kernels_aesni[] = {
+    make_kernel_aesni<cn::v1, aesni>("cn/1"),
+    make_kernel_aesni<cn::v0, aesni>("cn/0"),
+    make_kernel_aesni<cn::msr, aesni>("cn/msr"),
+    make_kernel_aesni<cn::v2, aesni>("cn/2"),
+    make_kernel_aesni<cn::half, aesni>("cn/half"),
+    make_kernel_aesni<cn::lite_v1, aesni>("cn-lite/1"),
+    make_kernel_aesni<cn::lite_v0, aesni>("cn-lite/0"),
+};
+
+} // namespace hash
+
+namespace dispatch {
+namespace detail {
+
+const monero_backend monero_aesni = {
+    "aesni", "aes", &hash::cn_kernel_aesni<hash::cn::v1, hash::aesni>, {
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::aesni, 1>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::aesni, 2>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::aesni, 3>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::aesni, 4>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::aesni, 5>,
+    },
+    hash::kernels_aesni, sizeof(hash::kernels_aesni) / sizeof(hash::kernels_aesni[0]),
+    &hash::cn_r_aesni<hash::aesni>
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
@@ -0,0 +1,165 @@
+// compiled with -maes -mssse3 (CMakeLists.txt), selected when the cpu reports both
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <fingera/config.hpp>
+#include <fingera/endian.hpp>
+#include "backends.hpp"
+#include <immintrin.h>
+
+namespace fingera {
+namespace hash {
+
+// Groestl-256 (groestl.c) on rows: register j holds row j of P's state in
+// its low and row j of Q's in its high 8 bytes, so one instruction stream
+// runs both permutations of the compression function. SubBytes is
+// AESENCLAST with a zero key, after a PSHUFB doing ShiftBytes and undoing
+// the AES ShiftRows; MixBytes is xors and doublings of whole rows.
+
+// ShiftBytes rotates row j of P left by j columns, of Q by these
+static constexpr int groestl_q_shift[8] = {1, 3, 5, 7, 0, 2, 4, 6};
+
+struct groestl_shuffles {
+    uint8_t row[8][16];
+};
+
+static constexpr groestl_shuffles make_groestl_shuffles() {
+    groestl_shuffles s{};
+    for (int j = 0; j < 8; j++) {
+        for (int x = 0; x < 16; x++) {
+            // AES ShiftRows brings byte i = r + 4 * c' to x = r + 4 * c
+            const int r = x & 3, c = x >> 2;
+            const int i = r + 4 * ((c + 4 - r) & 3);
+            const int shift = i < 8 ? j : groestl_q_shift[j];
+            s.row[j][x] = (uint8_t)((i & 8) | (((i & 7) + shift) & 7));
+        }
+    }
+    return s;
+}
+
+static constexpr groestl_shuffles groestl_shuffle = make_groestl_shuffles();
+
+// multiplication by 2 in GF(2^8) mod x^8 + x^4 + x^3 + x + 1, every byte
+static inline FINGERA_FORCEINLINE __m128i groestl_double(__m128i x) {
+    const __m128i carry = _mm_cmpgt_epi8(_mm_setzero_si128(), x);
+    return _mm_xor_si128(_mm_add_epi8(x, x), _mm_and_si128(carry, _mm_set1_epi8(0x1b)));
+}
+
+// a[j] = row j. MixBytes: row i = sum of circ(02, 02, 03, 04, 05, 03, 05,
+// 07)[k] * row i + k. Split by the bits of the coefficients, with t[k] =
+// row k ^ row k + 1: s1 + 2 * (s2 + 2 * s4) where s1 = a[i + 2] ^ t[i + 4]
+// ^ t[i + 6], s2 = t[i + 7] ^ t[i + 1] ^ a[i + 5], s4 = t[i + 3] ^ t[i + 6]
+template<int I>
+static inline FINGERA_FORCEINLINE __m128i groestl_mix_row(const __m128i *a, const __m128i *t) {
+    const __m128i s1 = _mm_xor_si128(a[(I + 2) & 7], _mm_xor_si128(t[(I + 4) & 7], t[(I + 6) & 7]));
+    const __m128i s2 = _mm_xor_si128(a[(I + 5) & 7], _mm_xor_si128(t[(I + 7) & 7], t[(I + 1) & 7]));
+    const __m128i s4 = _mm_xor_si128(t[(I + 3) & 7], t[(I + 6) & 7]);
+    return _mm_xor_si128(s1, groestl_double(_mm_xor_si128(s2, groestl_double(s4))));
+}
+
+template<int... I>
+static inline FINGERA_FORCEINLINE void groestl_round(__m128i *a, uint8_t round, std::integer_sequence<int, I...>) {
+    // AddRoundConstant: P row 0 gets column << 4 ^ round, Q every byte
+    // complemented and row 7 column << 4 ^ round on top
+    const __m128i r = _mm_set1_epi8((char)round);
+    const __m128i ones = _mm_set_epi64x(-1, 0);
+    a[0] = _mm_xor_si128(a[0], _mm_xor_si128(_mm_set_epi64x(-1, 0x7060504030201000), _mm_unpacklo_epi64(r, _mm_setzero_si128())));
+    for (int j = 1; j < 7; j++) a[j] = _mm_xor_si128(a[j], ones);
+    a[7] = _mm_xor_si128(a[7], _mm_xor_si128(_mm_set_epi64x((int64_t)0x8f9fafbfcfdfeffful, 0), _mm_unpacklo_epi64(_mm_setzero_si128(), r)));
+
+    // SubBytes and ShiftBytes
+    int sub[] = {(a[I] = _mm_aesenclast_si128(_mm_shuffle_epi8(a[I], _mm_loadu_si128((const __m128i *)groestl_shuffle.row[I])),
+        _mm_setzero_si128()), 0)...};
+    (void)sub;
+
+    const __m128i t[8] = {_mm_xor_si128(a[I], a[(I + 1) & 7])...};
+    const __m128i b[8] = {groestl_mix_row<I>(a, t)...};
+    int store[] = {(a[I] = b[I], 0)...};
+    (void)store;
+}
+
+static inline FINGERA_FORCEINLINE void groestl_permute(__m128i *a) {
+    for (uint8_t round = 0; round < 10; round++) groestl_round(a, round, std::make_integer_sequence<int, 8>());
+}
+
+// h: rows 2i and 2i + 1 in h[i], block: 8 columns of 8 bytes
+static inline void groestl_compress(__m128i *h, const uint8_t *block) {
+    // transpose the columns into rows
+    const __m128i c01 = _mm_loadu_si128((const __m128i *)block + 0);
+    const __m128i c23 = _mm_loadu_si128((const __m128i *)block + 1);
+    const __m128i c45 = _mm_loadu_si128((const __m128i *)block + 2);
+    const __m128i c67 = _mm_loadu_si128((const __m128i *)block + 3);
+    const __m128i u0 = _mm_unpacklo_epi8(c01, _mm_unpackhi_epi64(c01, c01));
+    const __m128i u1 = _mm_unpacklo_epi8(c23, _mm_unpackhi_epi64(c23, c23));
+    const __m128i u2 = _mm_unpacklo_epi8(c45, _mm_unpackhi_epi64(c45, c45));
+    const __m128i u3 = _mm_unpacklo_epi8(c67, _mm_unpackhi_epi64(c67, c67));
+    const __m128i v0 = _mm_unpacklo_epi16(u0, u1), v1 = _mm_unpackhi_epi16(u0, u1);
+    const __m128i v2 = _mm_unpacklo_epi16(u2, u3), v3 = _mm_unpackhi_epi16(u2, u3);
+    const __m128i m[4] = {
+        _mm_unpacklo_epi32(v0, v2), _mm_unpackhi_epi32(v0, v2),
+        _mm_unpacklo_epi32(v1, v3), _mm_unpackhi_epi32(v1, v3),
+    };
+
+    // P(h ^ m) | Q(m)
+    __m128i a[8];
+    for (int i = 0; i < 4; i++) {
+        const __m128i p = _mm_xor_si128(h[i], m[i]);
+        a[2 * i] = _mm_unpacklo_epi64(p, m[i]);
+        a[2 * i + 1] = _mm_unpackhi_epi64(p, m[i]);
+    }
+    groestl_permute(a);
+    for (int i = 0; i < 4; i++) {
+        h[i] = _mm_xor_si128(h[i], _mm_xor_si128(_mm_unpacklo_epi64(a[2 * i], a[2 * i + 1]),
+            _mm_unpackhi_epi64(a[2 * i], a[2 * i + 1])));
+    }
+}
+
+static void groestl_aesni(const void *data, size_t length, char *hash) {
+    const uint8_t *in = (const uint8_t *)data;
+    // the output length, 256, big endian in the last column
+    __m128i h[4] = {
+        _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_set_epi64x(0, 0x0100000000000000)
+    };
+
+    uint64_t blocks = 0;
+    for (; length >= 64; length -= 64, in += 64, blocks++) groestl_compress(h, in);
+    // 0x80, zeros and the block count, a second block when it doesn't fit
+    uint8_t last[128] = {};
+    memcpy(last, in, length);
+    last[length] = 0x80;
+    const size_t padded = length + 1 > 56 ? 128 : 64;
+    blocks += padded / 64;
+    write_big<uint64_t>(last + padded - 8, blocks);
+    groestl_compress(h, last);
+    if (padded == 128) groestl_compress(h, last + 64);
+
+    // h ^= P(h), Q's half unused
+    __m128i a[8];
+    for (int i = 0; i < 4; i++) {
+        a[2 * i] = h[i];
+        a[2 * i + 1] = _mm_unpackhi_epi64(h[i], h[i]);
+    }
+    groestl_permute(a);
+    uint8_t rows[64];
+    for (int i = 0; i < 4; i++) {
+        h[i] = _mm_xor_si128(h[i], _mm_unpacklo_epi64(a[2 * i], a[2 * i + 1]));
+        _mm_storeu_si128((__m128i *)rows + i, h[i]);
+    }
+    // the last 4 columns
+    for (int c = 4; c < 8; c++) {
+        for (int j = 0; j < 8; j++) hash[8 * (c - 4) + j] = (char)rows[8 * j + c];
+    }
+}
+
+} // namespace hash
+
+namespace dispatch {
+namespace detail {
+
+const monero_extra_backend monero_extra_aesni = {
+    "aesni", "aes ssse3", {nullptr, &hash::groestl_aesni, nullptr, nullptr}
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
@@ -0,0 +1,136 @@
+// compiled with -msse2 (CMakeLists.txt)
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <fingera/config.hpp>
+#include <fingera/endian.hpp>
+#include "backends.hpp"
+#include <emmintrin.h>
+extern "C" {
+// jh.c: 42 round constants of 256 bits, the JH-256 initial state
+extern const unsigned char E8_bitslice_roundconstant[42][32];
+extern const unsigned char JH256_H0[128];
+}
+
+namespace fingera {
+namespace hash {
+
+// JH-256 (jh.c) with one 128 bit register per state row: jh.c runs its
+// bitsliced rounds twice, once for each 64 bit half of a row, here both
+// halves go through the same instructions.
+
+// one half of jh.c SS: the bits of c pick S0 or S1 per S-box
+static inline FINGERA_FORCEINLINE void jh_sbox(__m128i &m0, __m128i &m1, __m128i &m2, __m128i &m3, __m128i c) {
+    m3 = _mm_xor_si128(m3, _mm_set1_epi32(-1));
+    m0 = _mm_xor_si128(m0, _mm_andnot_si128(m2, c));
+    const __m128i t = _mm_xor_si128(c, _mm_and_si128(m0, m1));
+    m0 = _mm_xor_si128(m0, _mm_and_si128(m2, m3));
+    m3 = _mm_xor_si128(m3, _mm_andnot_si128(m1, m2));
+    m1 = _mm_xor_si128(m1, _mm_and_si128(m0, m2));
+    m2 = _mm_xor_si128(m2, _mm_andnot_si128(m3, m0));
+    m0 = _mm_xor_si128(m0, _mm_or_si128(m1, m3));
+    m3 = _mm_xor_si128(m3, _mm_and_si128(m1, m2));
+    m1 = _mm_xor_si128(m1, _mm_and_si128(t, m0));
+    m2 = _mm_xor_si128(m2, t);
+}
+
+// swaps the bit groups of width W selected by mask with their neighbours
+template<int W>
+static inline FINGERA_FORCEINLINE __m128i jh_swap_bits(__m128i x, uint8_t mask) {
+    const __m128i low = _mm_set1_epi8((char)mask);
+    return _mm_or_si128(_mm_slli_epi64(_mm_and_si128(x, low), W), _mm_srli_epi64(_mm_andnot_si128(low, x), W));
+}
+
+// the swapping layer of round 7 * k + R, wider groups by lanes
+template<int R>
+static inline FINGERA_FORCEINLINE __m128i jh_swap(__m128i x) {
+    switch (R) {
+    case 0: return jh_swap_bits<1>(x, 0x55);
+    case 1: return jh_swap_bits<2>(x, 0x33);
+    case 2: return jh_swap_bits<4>(x, 0x0f);
+    case 3: return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    case 4: return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xb1), 0xb1);
+    case 5: return _mm_shuffle_epi32(x, 0xb1);
+    default: return _mm_shuffle_epi32(x, 0x4e);
+    }
+}
+
+// round 7 * k + R: S-boxes, the MDS layer L and swapping the odd rows
+template<int R>
+static inline FINGERA_FORCEINLINE void jh_round(__m128i &x0, __m128i &x1, __m128i &x2, __m128i &x3,
+        __m128i &x4, __m128i &x5, __m128i &x6, __m128i &x7, int k) {
+    const __m128i *c = (const __m128i *)E8_bitslice_roundconstant[7 * k + R];
+    jh_sbox(x0, x2, x4, x6, _mm_loadu_si128(c));
+    jh_sbox(x1, x3, x5, x7, _mm_loadu_si128(c + 1));
+
+    x1 = _mm_xor_si128(x1, x2);
+    x3 = _mm_xor_si128(x3, x4);
+    x5 = _mm_xor_si128(x5, _mm_xor_si128(x0, x6));
+    x7 = _mm_xor_si128(x7, x0);
+    x0 = _mm_xor_si128(x0, x3);
+    x2 = _mm_xor_si128(x2, x5);
+    x4 = _mm_xor_si128(x4, _mm_xor_si128(x1, x7));
+    x6 = _mm_xor_si128(x6, x1);
+
+    x1 = jh_swap<R>(x1);
+    x3 = jh_swap<R>(x3);
+    x5 = jh_swap<R>(x5);
+    x7 = jh_swap<R>(x7);
+}
+
+template<int... R>
+static inline FINGERA_FORCEINLINE void jh_rounds(__m128i *state, std::integer_sequence<int, R...>) {
+    // named copies the rounds keep in registers
+    __m128i x0 = state[0], x1 = state[1], x2 = state[2], x3 = state[3];
+    __m128i x4 = state[4], x5 = state[5], x6 = state[6], x7 = state[7];
+    for (int k = 0; k < 6; k++) {
+        int round[] = {(jh_round<R>(x0, x1, x2, x3, x4, x5, x6, x7, k), 0)...};
+        (void)round;
+    }
+    state[0] = x0; state[1] = x1; state[2] = x2; state[3] = x3;
+    state[4] = x4; state[5] = x5; state[6] = x6; state[7] = x7;
+}
+
+static inline void jh_compress(__m128i *x, const uint8_t *block) {
+    __m128i m[4];
+    for (int i = 0; i < 4; i++) {
+        m[i] = _mm_loadu_si128((const __m128i *)block + i);
+        x[i] = _mm_xor_si128(x[i], m[i]);
+    }
+    jh_rounds(x, std::make_integer_sequence<int, 7>());
+    for (int i = 0; i < 4; i++) x[4 + i] = _mm_xor_si128(x[4 + i], m[i]);
+}
+
+static void jh_sse2(const void *data, size_t length, char *hash) {
+    const uint8_t *in = (const uint8_t *)data;
+    __m128i x[8];
+    for (int i = 0; i < 8; i++) x[i] = _mm_loadu_si128((const __m128i *)JH256_H0 + i);
+
+    const uint64_t bits = (uint64_t)length * 8;
+    for (; length >= 64; length -= 64, in += 64) jh_compress(x, in);
+    // 0x80 and zeros up to a block, one more holding the length in bits
+    // big endian, just that one when the message fills its blocks
+    uint8_t last[128] = {};
+    memcpy(last, in, length);
+    last[length] = 0x80;
+    const size_t padded = length ? 128 : 64;
+    write_big<uint64_t>(last + padded - 8, bits);
+    jh_compress(x, last);
+    if (padded == 128) jh_compress(x, last + 64);
+
+    _mm_storeu_si128((__m128i *)hash, x[6]);
+    _mm_storeu_si128((__m128i *)hash + 1, x[7]);
+}
+
+} // namespace hash
+
+namespace dispatch {
+namespace detail {
+
+const monero_extra_backend monero_extra_sse2 = {
+    "sse2", "sse2", {nullptr, nullptr, &hash::jh_sse2, nullptr}
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
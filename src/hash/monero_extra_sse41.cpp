@@ -0,0 +1,152 @@
+// compiled with -msse4.1 (CMakeLists.txt)
+#include <cstdint>
+#include <cstring>
+#include <fingera/config.hpp>
+#include <fingera/endian.hpp>
+#include "backends.hpp"
+#include <smmintrin.h>
+
+namespace fingera {
+namespace hash {
+
+// BLAKE-256 (blake256.c) on rows: v0 .. v3, v4 .. v7, v8 .. v11 and v12 ..
+// v15 each in a register, so the four G of a column step run in the lanes
+// at once, the diagonal step after rotating rows 1 .. 3 into columns.
+
+static constexpr uint8_t blake_sigma[10][16] = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+    {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+    {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+    { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+    { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+    { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+    {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+    {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+    { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+    {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0},
+};
+
+static constexpr uint32_t blake_c[16] = {
+    0x243F6A88, 0x85A308D3, 0x13198A2E, 0x03707344, 0xA4093822, 0x299F31D0, 0x082EFA98, 0xEC4E6C89,
+    0x452821E6, 0x38D01377, 0xBE5466CF, 0x34E90C6C, 0xC0AC29B7, 0xC97C50DD, 0x3F84D5B5, 0xB5470917,
+};
+
+// the constants G adds to the message words: for round r and its four
+// message vectors (column first, column second, diagonal first, diagonal
+// second) lane i holds c[sigma[r][2i + 1]], c[sigma[r][2i]], then the same
+// from sigma[r][8 + 2i]
+struct blake_round_constants {
+    uint32_t c[10][4][4];
+};
+
+static constexpr blake_round_constants make_blake_round_constants() {
+    blake_round_constants k{};
+    for (int r = 0; r < 10; r++) {
+        for (int i = 0; i < 4; i++) {
+            k.c[r][0][i] = blake_c[blake_sigma[r][2 * i + 1]];
+            k.c[r][1][i] = blake_c[blake_sigma[r][2 * i]];
+            k.c[r][2][i] = blake_c[blake_sigma[r][8 + 2 * i + 1]];
+            k.c[r][3][i] = blake_c[blake_sigma[r][8 + 2 * i]];
+        }
+    }
+    return k;
+}
+
+static constexpr blake_round_constants blake_round_constant = make_blake_round_constants();
+
+static inline FINGERA_FORCEINLINE __m128i blake_rotr(__m128i x, int n) {
+    return _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - n));
+}
+
+// message words sigma[r][s], sigma[r][s + 2], sigma[r][s + 4], sigma[r][s + 6]
+// xored with their constants
+static inline FINGERA_FORCEINLINE __m128i blake_message(const uint32_t *m, int r, int s, int k) {
+    const uint8_t *sigma = blake_sigma[r];
+    __m128i x = _mm_cvtsi32_si128((int)m[sigma[s]]);
+    x = _mm_insert_epi32(x, (int)m[sigma[s + 2]], 1);
+    x = _mm_insert_epi32(x, (int)m[sigma[s + 4]], 2);
+    x = _mm_insert_epi32(x, (int)m[sigma[s + 6]], 3);
+    return _mm_xor_si128(x, _mm_loadu_si128((const __m128i *)blake_round_constant.c[r][k]));
+}
+
+static inline FINGERA_FORCEINLINE void blake_g(__m128i *v, __m128i m0, __m128i m1) {
+    const __m128i rotr16 = _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    const __m128i rotr8 = _mm_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1);
+    v[0] = _mm_add_epi32(v[0], _mm_add_epi32(m0, v[1]));
+    v[3] = _mm_shuffle_epi8(_mm_xor_si128(v[3], v[0]), rotr16);
+    v[2] = _mm_add_epi32(v[2], v[3]);
+    v[1] = blake_rotr(_mm_xor_si128(v[1], v[2]), 12);
+    v[0] = _mm_add_epi32(v[0], _mm_add_epi32(m1, v[1]));
+    v[3] = _mm_shuffle_epi8(_mm_xor_si128(v[3], v[0]), rotr8);
+    v[2] = _mm_add_epi32(v[2], v[3]);
+    v[1] = blake_rotr(_mm_xor_si128(v[1], v[2]), 7);
+}
+
+// t: message bits up to the end of this block, 0 for a block without any
+static inline void blake_compress(__m128i *h, const uint8_t *block, uint64_t t) {
+    uint32_t m[16];
+    const __m128i bswap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    for (int i = 0; i < 4; i++) {
+        _mm_storeu_si128((__m128i *)m + i, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)block + i), bswap));
+    }
+
+    __m128i v[4] = {
+        h[0], h[1],
+        _mm_loadu_si128((const __m128i *)blake_c),
+        _mm_xor_si128(_mm_loadu_si128((const __m128i *)blake_c + 1),
+            _mm_set_epi32((int)(t >> 32), (int)(t >> 32), (int)t, (int)t)),
+    };
+    for (int round = 0; round < 14; round++) {
+        const int r = round % 10;
+        blake_g(v, blake_message(m, r, 0, 0), blake_message(m, r, 1, 1));
+        // v4 .. v7 to v5 v6 v7 v4, so lane i holds the diagonal from v[i]
+        v[1] = _mm_shuffle_epi32(v[1], 0x39);
+        v[2] = _mm_shuffle_epi32(v[2], 0x4e);
+        v[3] = _mm_shuffle_epi32(v[3], 0x93);
+        blake_g(v, blake_message(m, r, 8, 2), blake_message(m, r, 9, 3));
+        v[1] = _mm_shuffle_epi32(v[1], 0x93);
+        v[2] = _mm_shuffle_epi32(v[2], 0x4e);
+        v[3] = _mm_shuffle_epi32(v[3], 0x39);
+    }
+    h[0] = _mm_xor_si128(h[0], _mm_xor_si128(v[0], v[2]));
+    h[1] = _mm_xor_si128(h[1], _mm_xor_si128(v[1], v[3]));
+}
+
+static void blake256_sse41(const void *data, size_t length, char *hash) {
+    const uint8_t *in = (const uint8_t *)data;
+    __m128i h[2] = {
+        _mm_set_epi32((int)0xA54FF53A, 0x3C6EF372, (int)0xBB67AE85, 0x6A09E667),
+        _mm_set_epi32(0x5BE0CD19, 0x1F83D9AB, (int)0x9B05688C, 0x510E527F),
+    };
+
+    const uint64_t bits = (uint64_t)length * 8;
+    uint64_t t = 0;
+    for (; length >= 64; length -= 64, in += 64) blake_compress(h, in, t += 512);
+    // 0x80, zeros, 0x01 ending byte 55 and the length in bits big endian,
+    // a second block when the message leaves less than 9 bytes
+    uint8_t last[128] = {};
+    memcpy(last, in, length);
+    last[length] = 0x80;
+    const size_t padded = length >= 56 ? 128 : 64;
+    last[padded - 9] |= 0x01;
+    write_big<uint64_t>(last + padded - 8, bits);
+    blake_compress(h, last, length ? bits : 0);
+    if (padded == 128) blake_compress(h, last + 64, 0);
+
+    const __m128i bswap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    _mm_storeu_si128((__m128i *)hash, _mm_shuffle_epi8(h[0], bswap));
+    _mm_storeu_si128((__m128i *)hash + 1, _mm_shuffle_epi8(h[1], bswap));
+}
+
+} // namespace hash
+
+namespace dispatch {
+namespace detail {
+
+const monero_extra_backend monero_extra_sse41 = {
+    "sse4.1", "sse4.1", {&hash::blake256_sse41, nullptr, nullptr, nullptr}
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
@@ -0,0 +1,76 @@
+// compiled with -msse2 (CMakeLists.txt), for cpus without AES-NI
+#include "backends.hpp"
+#include "cryptonight_aesni.hpp"
+extern "C" {
+// aesb.c: t_fn[r][x] = column r of MixColumns(SubBytes(x))
+extern const uint32_t t_fn[4][256];
+}
+
+namespace fingera {
+namespace hash {
+
+// The AES-NI kernels with table rounds: one lookup per state byte, no key
+// schedule allocation, every lane interleaved as on AES-NI. Not constant
+// time, as aesb.c.
+struct cn_aes_soft {
+    static inline FINGERA_FORCEINLINE uint32_t sub_word(uint32_t x) {
+        return ((t_fn[0][x & 0xff] >> 8) & 0xff) |
+            (t_fn[0][(x >> 8) & 0xff] & 0xff00) |
+            ((t_fn[0][(x >> 16) & 0xff] << 8) & 0xff0000) |
+            ((t_fn[0][x >> 24] << 16) & 0xff000000);
+    }
+
+    static inline FINGERA_FORCEINLINE __m128i enc(__m128i x, __m128i key) {
+        const uint32_t x0 = _mm_cvtsi128_si32(x);
+        const uint32_t x1 = _mm_cvtsi128_si32(_mm_shuffle_epi32(x, 0x55));
+        const uint32_t x2 = _mm_cvtsi128_si32(_mm_shuffle_epi32(x, 0xAA));
+        const uint32_t x3 = _mm_cvtsi128_si32(_mm_shuffle_epi32(x, 0xFF));
+        // column c takes row r from column c + r: ShiftRows
+        const __m128i y = _mm_set_epi32(
+            t_fn[0][x3 & 0xff] ^ t_fn[1][(x0 >> 8) & 0xff] ^ t_fn[2][(x1 >> 16) & 0xff] ^ t_fn[3][x2 >> 24],
+            t_fn[0][x2 & 0xff] ^ t_fn[1][(x3 >> 8) & 0xff] ^ t_fn[2][(x0 >> 16) & 0xff] ^ t_fn[3][x1 >> 24],
+            t_fn[0][x1 & 0xff] ^ t_fn[1][(x2 >> 8) & 0xff] ^ t_fn[2][(x3 >> 16) & 0xff] ^ t_fn[3][x0 >> 24],
+            t_fn[0][x0 & 0xff] ^ t_fn[1][(x1 >> 8) & 0xff] ^ t_fn[2][(x2 >> 16) & 0xff] ^ t_fn[3][x3 >> 24]);
+        return _mm_xor_si128(y, key);
+    }
+
+    template<uint8_t rcon>
+    static inline FINGERA_FORCEINLINE __m128i keygenassist(__m128i x) {
+        const uint32_t x1 = sub_word(_mm_cvtsi128_si32(_mm_shuffle_epi32(x, 0x55)));
+        const uint32_t x3 = sub_word(_mm_cvtsi128_si32(_mm_shuffle_epi32(x, 0xFF)));
+        return _mm_set_epi32(((x3 >> 8) | (x3 << 24)) ^ rcon, x3, ((x1 >> 8) | (x1 << 24)) ^ rcon, x1);
+    }
+};
+
+using softaes = cn_scratchpad_aes<cn_aes_soft>;
+
+static constexpr dispatch::cryptonight_kernel kernels_softaes[] = {
+    make_kernel_aesni<cn::v1, softaes>("cn/1"),
+    make_kernel_aesni<cn::v0, softaes>("cn/0"),
+    make_kernel_aesni<cn::msr, softaes>("cn/msr"),
+    make_kernel_aesni<cn::v2, softaes>("cn/2"),
+    make_kernel_aesni<cn::half, softaes>("cn/half"),
+    make_kernel_aesni<cn::lite_v1, softaes>("cn-lite/1"),
+    make_kernel_aesni<cn::lite_v0, softaes>("cn-lite/0"),
+};
+
+} // namespace hash
+
+namespace dispatch {
+namespace detail {
+
+const monero_backend monero_softaes = {
+    "softaes", "sse2", &hash::cn_kernel_aesni<hash::cn::v1, hash::softaes>, {
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::softaes, 1>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::softaes, 2>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::softaes, 3>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::softaes, 4>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::softaes, 5>,
+    },
+    hash::kernels_softaes, sizeof(hash::kernels_softaes) / sizeof(hash::kernels_softaes[0]),
+    &hash::cn_r_aesni<hash::softaes>
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
@@ -0,0 +1,157 @@
+// compiled with -maes -mvaes -mavx2 (CMakeLists.txt), every VAES cpu has AVX2
+#include "backends.hpp"
+#include "cryptonight_aesni.hpp"
+
+namespace fingera {
+namespace hash {
+
+// lines 2j and 2j + 1 of one scratchpad share a ymm register: 4 instead of
+// 8 AES instructions per round and 128 bytes
+struct cn_vaes_lines {
+    __m256i x0, x1, x2, x3;
+};
+
+static inline FINGERA_FORCEINLINE void vaes_expand_key(const __m128i *memory, __m256i *k) {
+    __m128i k0, k1, k2, k3, k4, k5, k6, k7, k8, k9;
+    aes_expand_key<cn_aes_hw>(memory, &k0, &k1, &k2, &k3, &k4, &k5, &k6, &k7, &k8, &k9);
+    k[0] = _mm256_broadcastsi128_si256(k0);
+    k[1] = _mm256_broadcastsi128_si256(k1);
+    k[2] = _mm256_broadcastsi128_si256(k2);
+    k[3] = _mm256_broadcastsi128_si256(k3);
+    k[4] = _mm256_broadcastsi128_si256(k4);
+    k[5] = _mm256_broadcastsi128_si256(k5);
+    k[6] = _mm256_broadcastsi128_si256(k6);
+    k[7] = _mm256_broadcastsi128_si256(k7);
+    k[8] = _mm256_broadcastsi128_si256(k8);
+    k[9] = _mm256_broadcastsi128_si256(k9);
+}
+
+static inline FINGERA_FORCEINLINE void vaes_load(cn_vaes_lines &v, const __m128i *p) {
+    v.x0 = _mm256_loadu_si256((const __m256i *)p + 0);
+    v.x1 = _mm256_loadu_si256((const __m256i *)p + 1);
+    v.x2 = _mm256_loadu_si256((const __m256i *)p + 2);
+    v.x3 = _mm256_loadu_si256((const __m256i *)p + 3);
+}
+
+static inline FINGERA_FORCEINLINE void vaes_store(const cn_vaes_lines &v, __m128i *p) {
+    _mm256_storeu_si256((__m256i *)p + 0, v.x0);
+    _mm256_storeu_si256((__m256i *)p + 1, v.x1);
+    _mm256_storeu_si256((__m256i *)p + 2, v.x2);
+    _mm256_storeu_si256((__m256i *)p + 3, v.x3);
+}
+
+static inline FINGERA_FORCEINLINE void vaes_xor(cn_vaes_lines &v, const __m128i *p) {
+    v.x0 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p + 0), v.x0);
+    v.x1 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p + 1), v.x1);
+    v.x2 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p + 2), v.x2);
+    v.x3 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)p + 3), v.x3);
+}
+
+static inline FINGERA_FORCEINLINE void vaes_round(cn_vaes_lines &v, __m256i key) {
+    v.x0 = _mm256_aesenc_epi128(v.x0, key);
+    v.x1 = _mm256_aesenc_epi128(v.x1, key);
+    v.x2 = _mm256_aesenc_epi128(v.x2, key);
+    v.x3 = _mm256_aesenc_epi128(v.x3, key);
+}
+
+// Every round of every scratchpad in the group before the next round, so
+// 4 * sizeof...(G) independent AES chains hide the instruction latency
+template<int... G>
+static inline FINGERA_FORCEINLINE void vaes_rounds(cn_vaes_lines *v, __m256i (*k)[10], std::integer_sequence<int, G...>) {
+    for (int r = 0; r < 10; r++) {
+        int order[] = {(vaes_round(v[G], k[G][r]), 0)...};
+        (void)order;
+    }
+}
+
+template<size_t Memory, int... G>
+static inline void cn_explode_vaes(const __m128i *const *states, __m128i *const *scratchpads,
+        std::integer_sequence<int, G...> group) {
+    __m256i k[sizeof...(G)][10];
+    cn_vaes_lines v[sizeof...(G)];
+    int init[] = {(vaes_expand_key(states[G], k[G]), vaes_load(v[G], states[G] + 4), 0)...};
+    (void)init;
+
+    for (size_t i = 0; i < Memory / 16; i += 8) {
+        vaes_rounds(v, k, group);
+        int store[] = {(vaes_store(v[G], scratchpads[G] + i), 0)...};
+        (void)store;
+    }
+}
+
+template<size_t Memory, int... G>
+static inline void cn_implode_vaes(const __m128i *const *scratchpads, __m128i *const *states,
+        std::integer_sequence<int, G...> group) {
+    __m256i k[sizeof...(G)][10];
+    cn_vaes_lines v[sizeof...(G)];
+    int init[] = {(vaes_expand_key(states[G] + 2, k[G]), vaes_load(v[G], states[G] + 4), 0)...};
+    (void)init;
+
+    for (size_t i = 0; i < Memory / 16; i += 8) {
+        int load[] = {(vaes_xor(v[G], scratchpads[G] + i), 0)...};
+        (void)load;
+        vaes_rounds(v, k, group);
+    }
+
+    int store[] = {(vaes_store(v[G], states[G] + 4), 0)...};
+    (void)store;
+}
+
+// Scratchpads two at a time: 8 ymm chains fill the AES units of Ice Lake
+// and Zen 3 without spilling the 16 ymm registers
+struct cn_scratchpad_vaes {
+    using aes = cn_aes_hw;
+
+    template<size_t Memory, int N>
+    static inline void explode(const __m128i *const *states, __m128i *const *scratchpads) {
+        for (int n = 0; n + 1 < N; n += 2) {
+            cn_explode_vaes<Memory>(states + n, scratchpads + n, std::make_integer_sequence<int, 2>());
+        }
+        if (N & 1) {
+            cn_explode_vaes<Memory>(states + N - 1, scratchpads + N - 1, std::make_integer_sequence<int, 1>());
+        }
+    }
+
+    template<size_t Memory, int N>
+    static inline void implode(const __m128i *const *scratchpads, __m128i *const *states) {
+        for (int n = 0; n + 1 < N; n += 2) {
+            cn_implode_vaes<Memory>(scratchpads + n, states + n, std::make_integer_sequence<int, 2>());
+        }
+        if (N & 1) {
+            cn_implode_vaes<Memory>(scratchpads + N - 1, states + N - 1, std::make_integer_sequence<int, 1>());
+        }
+    }
+};
+
+using vaes = cn_scratchpad_vaes;
+
+static constexpr dispatch::cryptonight_kernel kernels_vaes[] = {
+    make_kernel_aesni<cn::v1, vaes>("cn/1"),
+    make_kernel_aesni<cn::v0, vaes>("cn/0"),
+    make_kernel_aesni<cn::msr, vaes>("cn/msr"),
+    make_kernel_aesni<cn::v2, vaes>("cn/2"),
+    make_kernel_aesni<cn::half, vaes>("cn/half"),
+    make_kernel_aesni<cn::lite_v1, vaes>("cn-lite/1"),
+    make_kernel_aesni<cn::lite_v0, vaes>("cn-lite/0"),
+};
+
+} // namespace hash
+
+namespace dispatch {
+namespace detail {
+
+const monero_backend monero_vaes = {
+    "vaes", "vaes", &hash::cn_kernel_aesni<hash::cn::v1, hash::vaes>, {
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::vaes, 1>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::vaes, 2>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::vaes, 3>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::vaes, 4>,
+        &hash::cn_kernel_multi_aesni<hash::cn::v1, hash::vaes, 5>,
+    },
+    hash::kernels_vaes, sizeof(hash::kernels_vaes) / sizeof(hash::kernels_vaes[0]),
+    &hash::cn_r_aesni<hash::vaes>
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
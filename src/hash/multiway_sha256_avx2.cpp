@@ -0,0 +1,25 @@
+#include <fingera/config.hpp>
+// compiled with -mavx2 (CMakeLists.txt), whatever the build host detected
+#if !defined(FINGERA_USE_AVX2)
+#define FINGERA_USE_AVX2
+#endif
+#include <fingera/instrinsic/mi_avx2.hpp>
+#include <fingera/hash/multiway_sha256.hpp>
+#include "backends.hpp"
+
+namespace fingera {
+namespace dispatch {
+namespace detail {
+
+const sha256_backend sha256_avx2 = {
+    "avx2", "avx2", instrinsic::mi_avx2::way(),
+    &hash::multiway_sha256<instrinsic::mi_avx2>::process_trunk,
+    &hash::multiway_sha256<instrinsic::mi_avx2>::process_trunk_lanes,
+    &hash::multiway_sha256<instrinsic::mi_avx2>::process_many,
+    &hash::multiway_sha256<instrinsic::mi_avx2>::sha256d_64,
+    &hash::multiway_sha256<instrinsic::mi_avx2>::scan_nonces
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
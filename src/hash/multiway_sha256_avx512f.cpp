@@ -0,0 +1,25 @@
+#include <fingera/config.hpp>
+// compiled with -mavx512f (CMakeLists.txt), whatever the build host detected
+#if !defined(FINGERA_USE_AVX512F)
+#define FINGERA_USE_AVX512F
+#endif
+#include <fingera/instrinsic/mi_avx512.hpp>
+#include <fingera/hash/multiway_sha256.hpp>
+#include "backends.hpp"
+
+namespace fingera {
+namespace dispatch {
+namespace detail {
+
+const sha256_backend sha256_avx512f = {
+    "avx512f", "avx512f", instrinsic::mi_avx512::way(),
+    &hash::multiway_sha256<instrinsic::mi_avx512>::process_trunk,
+    &hash::multiway_sha256<instrinsic::mi_avx512>::process_trunk_lanes,
+    &hash::multiway_sha256<instrinsic::mi_avx512>::process_many,
+    &hash::multiway_sha256<instrinsic::mi_avx512>::sha256d_64,
+    &hash::multiway_sha256<instrinsic::mi_avx512>::scan_nonces
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
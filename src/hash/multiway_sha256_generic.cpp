@@ -0,0 +1,22 @@
+#include <fingera/multiway_integer.hpp>
+#include <fingera/hash/multiway_sha256.hpp>
+#include "backends.hpp"
+
+namespace fingera {
+namespace dispatch {
+namespace detail {
+
+using generic_1_way = multiway_integer<uint32_t, uint32_t>;
+
+const sha256_backend sha256_generic = {
+    "generic", nullptr, generic_1_way::way(),
+    &hash::multiway_sha256<generic_1_way>::process_trunk,
+    &hash::multiway_sha256<generic_1_way>::process_trunk_lanes,
+    &hash::multiway_sha256<generic_1_way>::process_many,
+    &hash::multiway_sha256<generic_1_way>::sha256d_64,
+    &hash::multiway_sha256<generic_1_way>::scan_nonces
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
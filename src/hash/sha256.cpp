@@ -0,0 +1,16 @@
+#include <fingera/hash/sha256.hpp>
+#include <fingera/dispatch.hpp>
+
+namespace fingera {
+namespace hash {
+
+void sha256_many(span<const void *const> messages, span<const size_t> lengths, span<uint8_t> out) {
+    if (messages.size() != lengths.size() || out.size() < messages.size() * 32) {
+        throw std::range_error("sha256_many: size mismatch");
+    }
+    if (messages.empty()) return;
+    dispatch::sha256().process_many(messages.data(), lengths.data(), messages.size(), out.data());
+}
+
+} // namespace hash
+} // namespace fingera
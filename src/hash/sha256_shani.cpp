@@ -0,0 +1,24 @@
+#include <fingera/config.hpp>
+// compiled with -msha -msse4.1 (CMakeLists.txt), whatever the build host detected
+#if !defined(FINGERA_USE_SHA)
+#define FINGERA_USE_SHA
+#endif
+#include <fingera/hash/sha256_shani.hpp>
+#include "backends.hpp"
+
+namespace fingera {
+namespace dispatch {
+namespace detail {
+
+const sha256_backend sha256_shani = {
+    "sha", "sha sse4.1", hash::sha256_shani::way(),
+    &hash::sha256_shani::process_trunk,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr
+};
+
+} // namespace detail
+} // namespace dispatch
+} // namespace fingera
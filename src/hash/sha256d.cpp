@@ -0,0 +1,56 @@
+#include <fingera/hash/sha256d.hpp>
+#include <cstring>
+#include <fingera/dispatch.hpp>
+#include "split_pairs.hpp"
+
+namespace fingera {
+namespace hash {
+
+std::vector<uint32_t> scan_nonces(const void *header80, uint32_t nonce_start, uint64_t count, const void *target) {
+    // every nonce of a chunk may hit, so found never overflows
+    const uint64_t chunk = 4096;
+    uint32_t found[chunk];
+    std::vector<uint32_t> r;
+    auto scan = dispatch::sha256().scan_nonces;
+    for (uint64_t done = 0; done < count; done += chunk) {
+        uint64_t n = count - done < chunk ? count - done : chunk;
+        size_t hits = scan(header80, nonce_start + (uint32_t)done, n, target, found, chunk);
+        r.insert(r.end(), found, found + hits);
+    }
+    return r;
+}
+
+void merkle_root(span<const uint8_t> leaves, void *root, unsigned threads) {
+    if (leaves.size() % 32) {
+        throw std::range_error("merkle_root: leaves is not a multiple of 32 bytes");
+    }
+    size_t count = leaves.size() / 32;
+    if (count == 0) {
+        memset(root, 0, 32);
+        return;
+    }
+
+    auto sha256d_64 = dispatch::sha256().sha256d_64;
+    std::vector<uint8_t> level(leaves.begin(), leaves.end());
+    std::vector<uint8_t> next;
+    while (count > 1) {
+        if (count & 1) {
+            // not insert() from level's own range, which may reallocate under it
+            level.resize(level.size() + 32);
+            memcpy(&level[level.size() - 32], &level[level.size() - 64], 32);
+            count++;
+        }
+        const size_t pairs = count / 2;
+        next.resize(pairs * 32);
+
+        split_pairs(pairs, threads, [&](size_t begin, size_t n) {
+            sha256d_64(&next[begin * 32], &level[begin * 64], n);
+        });
+        level.swap(next);
+        count = pairs;
+    }
+    memcpy(root, &level[0], 32);
+}
+
+} // namespace hash
+} // namespace fingera
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// One level of a hash tree over several threads, shared by merkle_root
+// (sha256d.cpp) and tree_hash_branch (tree_hash.cpp).
+namespace fingera {
+namespace hash {
+
+// hash_range(begin, n) over pairs 0 .. pairs - 1 in at most threads parts
+// of 1024 pairs or more, the first on the calling thread. Smaller levels
+// cost less than starting a thread.
+template<typename HashRange>
+static inline void split_pairs(size_t pairs, unsigned threads, HashRange hash_range) {
+    const size_t min_pairs_per_thread = 1024;
+    size_t parts = pairs / min_pairs_per_thread;
+    if (parts > threads) parts = threads;
+    if (parts <= 1) {
+        hash_range(0, pairs);
+        return;
+    }
+    std::vector<std::thread> workers;
+    const size_t step = (pairs + parts - 1) / parts;
+    for (size_t begin = step; begin < pairs; begin += step) {
+        workers.emplace_back(hash_range, begin, pairs - begin < step ? pairs - begin : step);
+    }
+    hash_range(0, step);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace hash
+} // namespace fingera
@@ -0,0 +1,73 @@
+#include <cstring>
+#include <stdexcept>
+#include <fingera/hash/monero.hpp>
+#include "split_pairs.hpp"
+
+namespace fingera {
+namespace hash {
+
+// out[i] = cn_fast_hash(in[2i] || in[2i + 1])
+static void hash_pairs(uint8_t *out, const uint8_t *in, size_t pairs, unsigned threads) {
+    split_pairs(pairs, threads, [out, in](size_t begin, size_t n) {
+        std::vector<const void *> messages(n);
+        std::vector<size_t> lengths(n, 64);
+        for (size_t i = 0; i < n; i++) messages[i] = in + (begin + i) * 64;
+        cn_fast_hash_many(&messages[0], &lengths[0], n, out + begin * 32);
+    });
+}
+
+tree_hash_branch::tree_hash_branch(const void *hashes, size_t count, unsigned threads) : _count(count) {
+    if (!count) throw std::invalid_argument("tree_hash_branch: no hashes");
+    const uint8_t *leaves = (const uint8_t *)hashes;
+    if (count == 1) return;
+
+    // tree-hash.c: cnt is the largest power of 2 below count, the first
+    // 2 cnt - count leaves go up unhashed and the rest in pairs make the
+    // other nodes of a cnt wide level, halved from there on
+    size_t cnt = 1;
+    while (cnt * 2 < count) cnt *= 2;
+    const size_t passed = 2 * cnt - count;
+    std::vector<uint8_t> level(cnt * 32), next;
+    memcpy(&level[0], leaves, passed * 32);
+    hash_pairs(&level[passed * 32], leaves + passed * 32, cnt - passed, threads);
+    if (!passed) _branch.assign(leaves + 32, leaves + 64);
+    // node 0 holds hashes[0]'s path, whatever was passed in, node 1 its sibling
+    while (cnt > 1) {
+        _branch.insert(_branch.end(), &level[32], &level[64]);
+        cnt /= 2;
+        next.resize(cnt * 32);
+        hash_pairs(&next[0], &level[0], cnt, threads);
+        level.swap(next);
+    }
+}
+
+void tree_hash_branch::root(const void *coinbase_hash, void *root) const {
+    uint8_t pair[64];
+    memcpy(pair, coinbase_hash, 32);
+    for (size_t i = 0; i < _branch.size(); i += 32) {
+        memcpy(pair + 32, &_branch[i], 32);
+        cn_fast_hash(pair, sizeof(pair), pair);
+    }
+    memcpy(root, pair, 32);
+}
+
+void tree_hash_branch::roots(const void *coinbase_hashes, size_t count, void *roots) const {
+    if (!count) return;
+    std::vector<uint8_t> pairs(count * 64), hashed(count * 32);
+    std::vector<const void *> messages(count);
+    std::vector<size_t> lengths(count, 64);
+    for (size_t n = 0; n < count; n++) {
+        memcpy(&pairs[n * 64], (const uint8_t *)coinbase_hashes + n * 32, 32);
+        messages[n] = &pairs[n * 64];
+    }
+    // every level hashes the count paths at once, each into its own first half
+    for (size_t i = 0; i < _branch.size(); i += 32) {
+        for (size_t n = 0; n < count; n++) memcpy(&pairs[n * 64 + 32], &_branch[i], 32);
+        cn_fast_hash_many(&messages[0], &lengths[0], count, &hashed[0]);
+        for (size_t n = 0; n < count; n++) memcpy(&pairs[n * 64], &hashed[n * 32], 32);
+    }
+    for (size_t n = 0; n < count; n++) memcpy((uint8_t *)roots + n * 32, &pairs[n * 64], 32);
+}
+
+} // namespace hash
+} // namespace fingera
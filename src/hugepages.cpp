@@ -0,0 +1,166 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <fingera/hugepages.hpp>
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+#endif
+#if defined(__linux__)
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace fingera {
+
+static const size_t huge_2m = (size_t)1 << 21;
+static const size_t huge_1g = (size_t)1 << 30;
+
+static std::atomic<uint64_t> counters[3];   // hugetlb, transparent, normal
+
+static size_t round_up(size_t size, size_t page) {
+    return (size + page - 1) / page * page;
+}
+
+static void *map_hugetlb(size_t size, size_t page) {
+#if defined(_WIN32)
+    // needs SeLockMemoryPrivilege, fails otherwise
+    if (page != huge_2m || GetLargePageMinimum() != huge_2m) return nullptr;
+    return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+#elif defined(MAP_HUGETLB)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    #if defined(MAP_HUGE_SHIFT)
+        flags |= (page == huge_1g ? 30 : 21) << MAP_HUGE_SHIFT;
+    #else
+        if (page != huge_2m) return nullptr;
+    #endif
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#else
+    (void)size;
+    (void)page;
+    return nullptr;
+#endif
+}
+
+#if defined(__linux__)
+// <numaif.h> comes with libnuma, these are the kernel ABI
+static const int mpol_preferred = 1;
+static const unsigned mpol_mf_move = 1 << 1;
+static const unsigned mpol_f_node = 1 << 0;
+static const unsigned mpol_f_addr = 1 << 1;
+static const int max_nodes = 1024;
+#endif
+
+static void bind_node(void *p, size_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    if (node < 0 || node >= max_nodes) return;
+    unsigned long mask[max_nodes / (8 * sizeof(unsigned long))] = {};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    // maxnode counts one past the mask bits, as libnuma passes it. Moves
+    // what the allocator already touched.
+    syscall(SYS_mbind, p, size, mpol_preferred, mask, (unsigned long)max_nodes + 1, mpol_mf_move);
+#else
+    (void)p;
+    (void)size;
+    (void)node;
+#endif
+}
+
+static void *alloc_aligned(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, huge_2m);
+#else
+    void *p = nullptr;
+    return posix_memalign(&p, huge_2m, size) == 0 ? p : nullptr;
+#endif
+}
+
+hugepage_buffer::hugepage_buffer(size_t size, int node) {
+    if (!size) return;
+    if (size % huge_1g == 0) {
+        _data = (uint8_t *)map_hugetlb(size, huge_1g);
+        _mapped = size;
+    }
+    if (!_data) {
+        _mapped = round_up(size, huge_2m);
+        _data = (uint8_t *)map_hugetlb(_mapped, huge_2m);
+    }
+    if (_data) {
+        _kind = hugetlb;
+    } else {
+        _mapped = round_up(size, huge_2m);
+        _data = (uint8_t *)alloc_aligned(_mapped);
+        if (!_data) throw std::bad_alloc();
+        _kind = normal;
+#if defined(MADV_HUGEPAGE)
+        if (madvise(_data, _mapped, MADV_HUGEPAGE) == 0) _kind = transparent;
+#endif
+    }
+    // before any page of it is touched
+    bind_node(_data, _mapped, node);
+    _size = size;
+    counters[_kind - hugetlb]++;
+}
+
+int hugepage_buffer::resident_node() const {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+    int node = -1;
+    if (_data && syscall(SYS_get_mempolicy, &node, nullptr, 0UL, _data, mpol_f_node | mpol_f_addr) == 0) {
+        return node;
+    }
+#endif
+    return -1;
+}
+
+hugepage_buffer::~hugepage_buffer() {
+    _release();
+}
+
+hugepage_buffer::hugepage_buffer(hugepage_buffer &&other)
+        : _data(other._data), _size(other._size), _mapped(other._mapped), _kind(other._kind) {
+    other._data = nullptr;
+    other._size = other._mapped = 0;
+    other._kind = none;
+}
+
+hugepage_buffer &hugepage_buffer::operator=(hugepage_buffer &&other) {
+    if (this != &other) {
+        _release();
+        _data = other._data;
+        _size = other._size;
+        _mapped = other._mapped;
+        _kind = other._kind;
+        other._data = nullptr;
+        other._size = other._mapped = 0;
+        other._kind = none;
+    }
+    return *this;
+}
+
+void hugepage_buffer::_release() {
+    if (!_data) return;
+    if (_kind == hugetlb) {
+#if defined(_WIN32)
+        VirtualFree(_data, 0, MEM_RELEASE);
+#else
+        munmap(_data, _mapped);
+#endif
+    } else {
+#if defined(_WIN32)
+        _aligned_free(_data);
+#else
+        free(_data);
+#endif
+    }
+    _data = nullptr;
+    _size = _mapped = 0;
+    _kind = none;
+}
+
+hugepage_counters get_hugepage_counters() {
+    return hugepage_counters{counters[0].load(), counters[1].load(), counters[2].load()};
+}
+
+} // namespace fingera
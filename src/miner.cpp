@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <fingera/miner.hpp>
+#include <fingera/cpu_features.hpp>
+#include <fingera/hash/monero.hpp>
+#include <fingera/hugepages.hpp>
+#if defined(_WIN32)
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace fingera {
+
+// One cpu of every core before any SMT sibling, cores round robin over the
+// last level caches so each cache (package, node) gets its share, within
+// a cache performance cores first
+static std::vector<int> placement(const cpu_topology &topology) {
+    const int last = topology.last_level();
+    std::map<int, std::vector<const cpu_core *>> domains;    // by first cpu of the cache
+    size_t siblings = 0, width = 0;
+    for (const cpu_core &core : topology.cores) {
+        int domain = 0;
+        for (const cpu_cache &cache : topology.caches) {
+            if (cache.level == last && std::binary_search(cache.cpus.begin(), cache.cpus.end(), core.cpus[0])) {
+                domain = cache.cpus[0];
+            }
+        }
+        std::vector<const cpu_core *> &cores = domains[domain];
+        cores.push_back(&core);
+        siblings = std::max(siblings, core.cpus.size());
+        width = std::max(width, cores.size());
+    }
+    for (auto &domain : domains) {
+        std::stable_sort(domain.second.begin(), domain.second.end(), [](const cpu_core *a, const cpu_core *b) {
+            return a->type == cpu_core::performance && b->type != cpu_core::performance;
+        });
+    }
+    std::vector<int> cpus;
+    for (size_t sibling = 0; sibling < siblings; sibling++) {
+        for (size_t i = 0; i < width; i++) {
+            for (auto &domain : domains) {
+                if (i < domain.second.size() && sibling < domain.second[i]->cpus.size()) {
+                    cpus.push_back(domain.second[i]->cpus[sibling]);
+                }
+            }
+        }
+    }
+    return cpus.empty() ? topology.cpus : cpus;
+}
+
+static bool pin_thread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    return cpu < 64 && SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// miner::default_threads on an already probed topology
+static size_t threads_for(const cpu_topology &topology, const char *algorithm, int ways) {
+    const size_t cpus = topology.cpus.size();
+    const size_t memory = hash::cryptonight_memory(algorithm) * std::max(ways, 1);
+    const size_t cache = topology.total_cache_size(topology.last_level());
+    if (!cache || !memory) return std::max<size_t>(1, cpus);
+    return std::max<size_t>(1, std::min(cpus, cache / memory));
+}
+
+size_t miner::default_threads(const char *algorithm, int ways) {
+    cpu_topology topology;
+    get_cpu_topology(topology);
+    return threads_for(topology, algorithm, ways);
+}
+
+miner::miner(share_handler on_share, const miner_options &options)
+    : _on_share(std::move(on_share)), _options(options) {
+    if (_options.ways < 1 || _options.ways > 5) throw std::invalid_argument("miner: ways out of 1 .. 5");
+    if (!_options.batch) throw std::invalid_argument("miner: batch 0");
+    get_cpu_topology(_topology);
+    // enough for any job, set_job decides how many mine
+    const size_t n = _options.threads ? _options.threads : std::max<size_t>(1, _topology.cpus.size());
+    const std::vector<int> cpus = placement(_topology);
+    for (size_t i = 0; i < n; i++) {
+        _workers.emplace_back(new worker);
+        if (_options.affinity && !cpus.empty()) {
+            _workers[i]->cpu = cpus[i % cpus.size()];
+            _workers[i]->node = _topology.node_of(cpus[i % cpus.size()]);
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        _workers[i]->thread = std::thread(&miner::_run, this, i);
+    }
+}
+
+miner::~miner() {
+    stop();
+}
+
+void miner::set_job(const miner_job &job) {
+    if (!hash::cryptonight_memory(job.algorithm.c_str())) {
+        throw std::invalid_argument("miner: unknown cryptonight algorithm " + job.algorithm);
+    }
+    if (job.blob.size() < 43) throw std::invalid_argument("miner: blob shorter than 43 bytes");
+    if (job.nonce_begin >= job.nonce_end || job.nonce_end > ((uint64_t)1 << 32)) {
+        throw std::invalid_argument("miner: bad nonce range");
+    }
+    std::shared_ptr<const miner_job> next = std::make_shared<miner_job>(job);
+    const size_t active = _options.threads ? _workers.size() :
+        std::min(_workers.size(), threads_for(_topology, job.algorithm.c_str(), _options.ways));
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = std::move(next);
+        _active = active;
+        _sequence++;
+    }
+    _wake.notify_all();
+}
+
+void miner::pause() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job.reset();
+        _sequence++;
+    }
+    _wake.notify_all();
+}
+
+void miner::stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (auto &w : _workers) {
+        if (w->thread.joinable()) w->thread.join();
+    }
+}
+
+size_t miner::active_threads() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _job ? _active : 0;
+}
+
+std::vector<miner_worker_stats> miner::stats() const {
+    std::vector<miner_worker_stats> result;
+    for (auto &w : _workers) {
+        result.push_back({w->cpu.load(), w->node.load(), w->memory_node.load(), w->hashes.load(), w->hashrate.load()});
+    }
+    return result;
+}
+
+std::vector<miner_node_stats> miner::node_stats() const {
+    std::map<int, miner_node_stats> nodes;
+    for (const miner_worker_stats &w : stats()) {
+        miner_node_stats &node = nodes.emplace(w.node, miner_node_stats{w.node, 0, 0, 0}).first->second;
+        node.workers++;
+        if (w.node >= 0 && w.memory_node >= 0 && w.memory_node != w.node) node.misplaced++;
+        node.hashrate += w.hashrate;
+    }
+    std::vector<miner_node_stats> result;
+    for (auto &node : nodes) result.push_back(node.second);
+    return result;
+}
+
+double miner::hashrate() const {
+    double total = 0;
+    for (auto &w : _workers) total += w->hashrate.load();
+    return total;
+}
+
+void miner::_run(size_t index) {
+    worker &w = *_workers[index];
+    if (w.cpu >= 0 && !pin_thread(w.cpu)) {
+        w.cpu = -1;
+        w.node = -1;
+    }
+    w.window = std::chrono::steady_clock::now();
+
+    // allocated here, after pinning: first touch places it near this cpu
+    hugepage_buffer scratchpad;
+    uint64_t seen = 0;
+    while (true) {
+        std::shared_ptr<const miner_job> job;
+        size_t active;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            auto ready = [&] { return _stopping || (_job && _sequence != seen); };
+            if (!ready()) {
+                w.hashrate = 0;
+                _wake.wait(lock, ready);
+                w.window = std::chrono::steady_clock::now();
+                w.window_hashes = 0;
+            }
+            if (_stopping) return;
+            job = _job;
+            active = _active;
+            seen = _sequence;
+        }
+        // past the job's thread count: idle until the next one
+        if (index < active) _mine(index, active, *job, seen, scratchpad);
+    }
+}
+
+void miner::_mine(size_t index, size_t active, const miner_job &job, uint64_t sequence,
+        hugepage_buffer &scratchpad) {
+    using clock = std::chrono::steady_clock;
+    worker &w = *_workers[index];
+    const size_t memory = hash::cryptonight_memory(job.algorithm.c_str()) * _options.ways;
+    if (scratchpad.size() < memory) {
+        scratchpad = hugepage_buffer(memory, w.node);
+        memset(scratchpad.data(), 0, memory);
+        w.memory_node = scratchpad.resident_node();
+    }
+
+    const hash::cryptonight_share on_share = [&](uint32_t nonce, const void *result) {
+        miner_share share;
+        share.job_id = job.id;
+        share.nonce = nonce;
+        memcpy(share.result, result, sizeof(share.result));
+        _on_share(share);
+    };
+    const uint64_t stride = (uint64_t)_options.batch * active;
+    for (uint64_t begin = job.nonce_begin + (uint64_t)_options.batch * index; begin < job.nonce_end; begin += stride) {
+        if (_stopping || _sequence != sequence) return;
+        const uint64_t end = std::min(begin + _options.batch, job.nonce_end);
+        hash::cryptonight_scan(job.algorithm.c_str(), &job.blob[0], job.blob.size(), begin, end, job.target64,
+            on_share, _options.ways, scratchpad.data());
+        w.hashes += end - begin;
+
+        w.window_hashes += end - begin;
+        const clock::time_point now = clock::now();
+        const double seconds = std::chrono::duration<double>(now - w.window).count();
+        if (seconds >= 1) {
+            w.hashrate = w.window_hashes / seconds;
+            w.window = now;
+            w.window_hashes = 0;
+        }
+    }
+}
+
+} // namespace fingera
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <vector>
+#include <fingera/endian.hpp>
+#include <fingera/hex.hpp>
+#include <fingera/multiway_integer.hpp>
+#include <fingera/hash/multiway_sha256.hpp>
+
+// Checks of multiway_sha256<Instr> for any lane type. The intrinsic ones run
+// from test_multiway_sha256_*.cpp, compiled with their target flags
+// (tests/CMakeLists.txt) and skipped when the running cpu lacks them.
+
+// precondition: get_cpu_features reports feature (test_multiway_sha256.cpp,
+// built without target flags)
+struct cpu_supports {
+    const char *feature;
+    boost::test_tools::assertion_result operator()(boost::unit_test::test_unit_id) const;
+};
+
+// process_trunk against the one way scalar engine, block by block
+template<typename Instr>
+static void check_process_trunk(const uint8_t *blocks, int count) {
+    using namespace fingera;
+    const int way = Instr::way();
+
+    std::vector<uint8_t> expected(32 * way);
+    std::vector<uint8_t> result(32 * way);
+    for (int i = 0; i < way; i++) {
+        std::vector<uint8_t> lane(count * 64);
+        for (int k = 0; k < count; k++) {
+            memcpy(&lane[k * 64], blocks + (k * way + i) * 64, 64);
+        }
+        hash::multiway_sha256<multiway_integer<uint32_t, uint32_t>>::process_trunk(&expected[i * 32], &lane[0], count);
+    }
+    hash::multiway_sha256<Instr>::process_trunk(&result[0], blocks, count);
+    BOOST_CHECK_EQUAL(to_hex(&result[0], result.size()), to_hex(&expected[0], expected.size()));
+}
+
+template<typename Instr>
+static void check_process_block_h(const uint8_t *blocks) {
+    using namespace fingera;
+    using sha256 = hash::multiway_sha256<Instr>;
+    using type = typename Instr::type;
+
+    type w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = Instr::template load<false>(blocks, 64, i * 4);
+    }
+    type a = Instr::op_broadcast(0x6a09e667ul);
+    type b = Instr::op_broadcast(0xbb67ae85ul);
+    type c = Instr::op_broadcast(0x3c6ef372ul);
+    type d = Instr::op_broadcast(0xa54ff53aul);
+    type e = Instr::op_broadcast(0x510e527ful);
+    type f = Instr::op_broadcast(0x9b05688cul);
+    type g = Instr::op_broadcast(0x1f83d9abul);
+    type h = Instr::op_broadcast(0x5be0cd19ul);
+    type only_h = sha256::process_block_h(a, b, c, d, e, f, g, h,
+        w[0], w[1], w[2], w[3], w[4], w[5], w[6], w[7], w[8], w[9], w[10], w[11], w[12], w[13], w[14], w[15]);
+    sha256::process_block(a, b, c, d, e, f, g, h,
+        w[0], w[1], w[2], w[3], w[4], w[5], w[6], w[7], w[8], w[9], w[10], w[11], w[12], w[13], w[14], w[15]);
+
+    uint8_t expected[4 * Instr::way()];
+    uint8_t result[4 * Instr::way()];
+    Instr::template save<false>(h, expected, 4, 0);
+    Instr::template save<false>(only_h, result, 4, 0);
+    BOOST_CHECK_EQUAL(to_hex(result, sizeof(result)), to_hex(expected, sizeof(expected)));
+
+    // the lane's own top word always passes, one less never does
+    for (int i = 0; i < Instr::way(); i++) {
+        uint32_t top = read_little<uint32_t>(expected + i * 4);
+        BOOST_CHECK((sha256::hit_mask(only_h, top) >> i) & 1);
+        if (top) BOOST_CHECK(!((sha256::hit_mask(only_h, top - 1) >> i) & 1));
+    }
+}
+
+// process_trunk_lanes over the same blocks as process_trunk, relaid lane-major
+template<typename Instr>
+static void check_process_trunk_lanes(const uint8_t *blocks, int count) {
+    using namespace fingera;
+    using sha256 = hash::multiway_sha256<Instr>;
+    const int way = Instr::way();
+
+    std::vector<uint8_t> lanes(count * 64 * way);
+    for (int k = 0; k < count; k++) {
+        for (int i = 0; i < way; i++) {
+            for (int j = 0; j < 16; j++) {
+                uint32_t word = read_big<uint32_t>(blocks + (k * way + i) * 64 + j * 4);
+                write_little<uint32_t>(&lanes[((k * 16 + j) * way + i) * 4], word);
+            }
+        }
+    }
+    std::vector<uint8_t> expected(32 * way);
+    std::vector<uint8_t> state(32 * way);
+    std::vector<uint8_t> result(32 * way);
+    sha256::process_trunk(&expected[0], blocks, count);
+    sha256::process_trunk_lanes(&state[0], &lanes[0], count);
+    for (int i = 0; i < way; i++) {
+        for (int j = 0; j < 8; j++) {
+            write_big<uint32_t>(&result[i * 32 + j * 4], read_little<uint32_t>(&state[(j * way + i) * 4]));
+        }
+    }
+    BOOST_CHECK_EQUAL(to_hex(&result[0], result.size()), to_hex(&expected[0], expected.size()));
+}
+
+// process_block_const<Mask, Words...> against process_block on the same words
+template<typename Instr, uint32_t Mask, uint32_t... Words>
+static void check_process_block_const(const uint8_t *blocks) {
+    using namespace fingera;
+    using sha256 = hash::multiway_sha256<Instr>;
+    using type = typename Instr::type;
+
+    const uint32_t words[] = {Words...};
+    type w[16], wc[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = Instr::template load<false>(blocks, 64, i * 4);
+        wc[i] = w[i];
+        if ((Mask >> i) & 1) w[i] = Instr::op_broadcast(words[i]);
+    }
+    type s[8], sc[8];
+    for (int i = 0; i < 8; i++) {
+        s[i] = sc[i] = Instr::template load<false>(blocks, 64, 64 - 32 + i * 4);
+    }
+    sha256::process_block(s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7],
+        w[0], w[1], w[2], w[3], w[4], w[5], w[6], w[7], w[8], w[9], w[10], w[11], w[12], w[13], w[14], w[15]);
+    type h = sha256::template process_block_const_h<Mask, Words...>(sc[0], sc[1], sc[2], sc[3], sc[4], sc[5], sc[6], sc[7],
+        wc[0], wc[1], wc[2], wc[3], wc[4], wc[5], wc[6], wc[7], wc[8], wc[9], wc[10], wc[11], wc[12], wc[13], wc[14], wc[15]);
+    sha256::template process_block_const<Mask, Words...>(sc[0], sc[1], sc[2], sc[3], sc[4], sc[5], sc[6], sc[7],
+        wc[0], wc[1], wc[2], wc[3], wc[4], wc[5], wc[6], wc[7], wc[8], wc[9], wc[10], wc[11], wc[12], wc[13], wc[14], wc[15]);
+
+    uint8_t expected[32 * Instr::way()];
+    uint8_t result[32 * Instr::way()];
+    for (int i = 0; i < 8; i++) {
+        Instr::template save<false>(s[i], expected, 32, i * 4);
+        Instr::template save<false>(sc[i], result, 32, i * 4);
+    }
+    BOOST_CHECK_EQUAL(to_hex(result, sizeof(result)), to_hex(expected, sizeof(expected)));
+    Instr::template save<false>(h, result, 32, 28);
+    BOOST_CHECK_EQUAL(to_hex(result, sizeof(result)), to_hex(expected, sizeof(expected)));
+}
+
+template<typename Instr>
+static void check_process_block_const(const uint8_t *blocks) {
+    check_process_block_const<Instr, 0xffff,
+        0x80000000u, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 512>(blocks);
+    check_process_block_const<Instr, 0xfff0,
+        0, 0, 0, 0, 0x80000000u, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 640>(blocks);
+    check_process_block_const<Instr, 0xff00,
+        0, 0, 0, 0, 0, 0, 0, 0, 0x80000000u, 0, 0, 0, 0, 0, 0, 256>(blocks);
+    check_process_block_const<Instr, 0x8421,
+        0x01234567u, 0, 0, 0, 0, 0x89abcdefu, 0, 0, 0, 0, 0xdeadbeefu, 0, 0, 0, 0, 0xfedcba98u>(blocks);
+}
+
+// every check on one lane type, blocks of 3 * 16 * 64 bytes
+template<typename Instr>
+static void check_multiway_sha256(const uint8_t *blocks) {
+    check_process_trunk<Instr>(blocks, 3);
+    check_process_block_h<Instr>(blocks);
+    check_process_trunk_lanes<Instr>(blocks, 3);
+    check_process_block_const<Instr>(blocks);
+}
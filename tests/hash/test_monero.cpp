@@ -2,11 +2,23 @@
 #include <fingera/hash/monero.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <cstring>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include <iostream>
+#include <fingera/dispatch.hpp>
+#include <fingera/endian.hpp>
 #include <fingera/hex.hpp>
-
+#include <fingera/hugepages.hpp>
+extern "C" {
+#include "hash/monero/oaes_lib.h"
+// hash.c, the reference for cn_fast_hash
+void cn_fast_hash(const void *data, size_t length, char *hash);
+// aesb.c, the software AES key schedule
+void aesb_expand_key(const uint8_t *key, uint8_t *expandedKey);
+}
 
 BOOST_AUTO_TEST_SUITE(monero_tests)
 
@@ -27,4 +39,401 @@ BOOST_AUTO_TEST_CASE(base) {
     std::cout << fingera::to_hex(hash, 32) << std::endl;
 }
 
+// blobs differ in the nonce (offset 39), every one checked against monero_standard
+template<int N>
+static void check_cpu_fast_multi(const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> blobs[N];
+    const void *block_blobs[N];
+    size_t lengths[N];
+    char hashes[N][32];
+    void *results[N];
+    for (int n = 0; n < N; n++) {
+        blobs[n] = data;
+        blobs[n][39] = (uint8_t)(blobs[n][39] + n);
+        block_blobs[n] = &blobs[n][0];
+        lengths[n] = blobs[n].size();
+        results[n] = hashes[n];
+    }
+    fingera::hash::monero_cpu_fast_multi<N>(block_blobs, lengths, results);
+    char expected[N][32];
+    for (int n = 0; n < N; n++) {
+        fingera::hash::monero_standard(block_blobs[n], lengths[n], expected[n]);
+        BOOST_CHECK_EQUAL(fingera::to_hex(hashes[n], 32), fingera::to_hex(expected[n], 32));
+    }
+
+    fingera::hugepage_buffer scratchpad(fingera::hash::monero_scratchpad_size * N);
+    memset(hashes, 0, sizeof(hashes));
+    fingera::hash::monero_cpu_fast_multi<N>(block_blobs, lengths, results, scratchpad.data());
+    for (int n = 0; n < N; n++) {
+        BOOST_CHECK_EQUAL(fingera::to_hex(hashes[n], 32), fingera::to_hex(expected[n], 32));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(cpu_fast_multi) {
+    std::vector<uint8_t> data;
+    BOOST_CHECK(fingera::from_hex("0707c3d4a9db055ced477105ab5607d19fa12cf3f538f0e4e724f3bde40ddc05d16a9a068001885b038000b9ba16ee6a563456fc9ec93af68675a295f592992645a54175b375e66e32429e01", data));
+    check_cpu_fast_multi<1>(data);
+    check_cpu_fast_multi<2>(data);
+    check_cpu_fast_multi<3>(data);
+    check_cpu_fast_multi<4>(data);
+    check_cpu_fast_multi<5>(data);
+}
+
+// monero tests-slow-2.txt
+BOOST_AUTO_TEST_CASE(variant2) {
+    using namespace fingera;
+
+    const char *data = "This is a test This is a test This is a test";
+    const char *expected = "353fdc068fd47b03c04b9431e005e00b68c2168a3cc7335c8b9b308156591a4f";
+    char hash[32];
+    hugepage_buffer scratchpad(hash::cryptonight_memory("cn/2"));
+    for (auto backend : dispatch::monero_backends()) {
+        for (size_t i = 0; i < backend->kernel_count; i++) {
+            if (strcmp(backend->kernels[i].algorithm, "cn/2")) continue;
+            BOOST_TEST_MESSAGE("cn/2 backend " << backend->name);
+            memset(hash, 0, sizeof(hash));
+            backend->kernels[i].hash(data, strlen(data), hash, scratchpad.data());
+            BOOST_CHECK_EQUAL(to_hex(hash, 32), expected);
+        }
+    }
+
+    std::vector<uint8_t> v2;
+    BOOST_CHECK(from_hex("0707c3d4a9db055ced477105ab5607d19fa12cf3f538f0e4e724f3bde40ddc05d16a9a068001885b038000b9ba16ee6a563456fc9ec93af68675a295f592992645a54175b375e66e32429e01", v2));
+    v2[0] = 8; // major_version 8: variant 2
+    char standard[32];
+    hash::monero_standard(&v2[0], v2.size(), standard);
+    hash::cryptonight("cn/2", &v2[0], v2.size(), hash);
+    BOOST_CHECK_EQUAL(to_hex(hash, 32), to_hex(standard, 32));
+}
+
+// every backend implementing an algorithm agrees, cn/0 and cn/1 with cn_slow_hash
+BOOST_AUTO_TEST_CASE(cryptonight_family) {
+    using namespace fingera;
+
+    std::vector<uint8_t> data;
+    BOOST_CHECK(from_hex("0707c3d4a9db055ced477105ab5607d19fa12cf3f538f0e4e724f3bde40ddc05d16a9a068001885b038000b9ba16ee6a563456fc9ec93af68675a295f592992645a54175b375e66e32429e01", data));
+    char hash[32], expected[32];
+
+    hash::monero_standard(&data[0], data.size(), expected);
+    hash::cryptonight("cn/1", &data[0], data.size(), hash);
+    BOOST_CHECK_EQUAL(to_hex(hash, 32), to_hex(expected, 32));
+
+    std::vector<uint8_t> v0 = data;
+    v0[0] = 6; // major_version 6: variant 0
+    hash::monero_standard(&v0[0], v0.size(), expected);
+    hash::cryptonight("cn/0", &v0[0], v0.size(), hash);
+    BOOST_CHECK_EQUAL(to_hex(hash, 32), to_hex(expected, 32));
+
+    const char *algorithms[] = {"cn/0", "cn/1", "cn/msr", "cn/2", "cn/half", "cn-lite/0", "cn-lite/1"};
+    std::vector<std::string> seen;
+    for (auto algorithm : algorithms) {
+        BOOST_TEST_MESSAGE("cryptonight " << algorithm);
+        BOOST_CHECK_EQUAL(hash::cryptonight_memory(algorithm), dispatch::cryptonight(algorithm)->memory);
+        hash::cryptonight(algorithm, &data[0], data.size(), expected);
+        seen.push_back(to_hex(expected, 32));
+
+        hugepage_buffer scratchpad(hash::cryptonight_memory(algorithm) * 2);
+        for (auto backend : dispatch::monero_backends()) {
+            for (size_t i = 0; i < backend->kernel_count; i++) {
+                const dispatch::cryptonight_kernel &kernel = backend->kernels[i];
+                if (strcmp(kernel.algorithm, algorithm)) continue;
+                memset(hash, 0, sizeof(hash));
+                kernel.hash(&data[0], data.size(), hash, scratchpad.data());
+                BOOST_CHECK_EQUAL(to_hex(hash, 32), to_hex(expected, 32));
+
+                char hashes[2][32];
+                const void *blobs[2] = {&data[0], &data[0]};
+                size_t lengths[2] = {data.size(), data.size()};
+                void *results[2] = {hashes[0], hashes[1]};
+                kernel.hash_multi[1](blobs, lengths, results, scratchpad.data());
+                BOOST_CHECK_EQUAL(to_hex(hashes[0], 32), to_hex(expected, 32));
+                BOOST_CHECK_EQUAL(to_hex(hashes[1], 32), to_hex(expected, 32));
+            }
+        }
+    }
+    std::sort(seen.begin(), seen.end());
+    BOOST_CHECK(std::unique(seen.begin(), seen.end()) == seen.end());
+
+    BOOST_CHECK_EQUAL(hash::cryptonight_memory("cn-lite/1"), 1 << 20);
+    BOOST_CHECK_EQUAL(hash::cryptonight_memory("cn/unknown"), 0);
+    BOOST_CHECK(dispatch::cryptonight("cn/unknown") == nullptr);
+    BOOST_CHECK_THROW(hash::cryptonight("cn/unknown", &data[0], data.size(), hash), std::invalid_argument);
+}
+
+// every finalizer backend against the reference code and known digests
+BOOST_AUTO_TEST_CASE(extra_hashes) {
+    using namespace fingera;
+
+    struct {
+        int index;
+        const char *data;
+        const char *expected;
+    } vectors[] = {
+        {0, "", "716f6e863f744b9ac22c97ec7b76ea5f5908bc5b2f67c61510bfc4751384ea7a"},
+        {0, "The quick brown fox jumps over the lazy dog", "7576698ee9cad30173080678e5965916adbb11cb5245d386bf1ffda1cb26c9d7"},
+        {1, "", "1a52d11d550039be16107f9c58db9ebcc417f16f736adb2502567119f0083467"},
+        {1, "The quick brown fox jumps over the lazy dog", "8c7ad62eb26a21297bc39c2d7293b4bd4d3399fa8afab29e970471739e28b301"},
+        {2, "", "46e64619c18bb0a92a5e87185a47eef83ca747b8fcc8e1412921357e326df434"},
+        {2, "The quick brown fox jumps over the lazy dog", "6a049fed5fc6874acfdc4a08b568a4f8cbac27de933496f031015b38961608a0"},
+        {3, "", "39ccc4554a8b31853b9de7a1fe638a24cce6b35a55f2431009e18780335d2621"},
+        {3, "The quick brown fox jumps over the lazy dog", "b3250457e05d3060b1a4bbc1428bc75a3f525ca389aeab96cfa34638d96e492a"},
+    };
+    const dispatch::monero_extra_backend *reference = dispatch::monero_extra_backends().back();
+    BOOST_REQUIRE_EQUAL(reference->name, std::string("portable"));
+    std::vector<uint8_t> data(300);
+    for (size_t i = 0; i < data.size(); i++) data[i] = (uint8_t)(i * 7 + 3);
+    char hash[32], expected[32];
+
+    for (auto backend : dispatch::monero_extra_backends()) {
+        for (int i = 0; i < 4; i++) {
+            if (!backend->extra[i]) continue;
+            BOOST_TEST_MESSAGE("extra " << backend->name << " " << i);
+            for (auto &v : vectors) {
+                if (v.index != i) continue;
+                backend->extra[i](v.data, strlen(v.data), hash);
+                BOOST_CHECK_EQUAL(to_hex(hash, 32), v.expected);
+            }
+            // every padding case: one and two final blocks, block boundaries
+            for (size_t length = 0; length <= data.size(); length++) {
+                reference->extra[i](&data[0], length, expected);
+                backend->extra[i](&data[0], length, hash);
+                BOOST_CHECK_EQUAL(to_hex(hash, 32), to_hex(expected, 32));
+            }
+        }
+    }
+    for (int i = 0; i < 4; i++) BOOST_CHECK(dispatch::monero_extra()[i] != nullptr);
+}
+
+// known digests, then every padding case one by one and in a batch against hash.c
+BOOST_AUTO_TEST_CASE(fast_hash) {
+    using namespace fingera;
+
+    uint8_t hash[32];
+    hash::cn_fast_hash("", 0, hash);
+    BOOST_CHECK_EQUAL(to_hex(hash, 32), "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470");
+    const char *fox = "The quick brown fox jumps over the lazy dog";
+    hash::cn_fast_hash(fox, strlen(fox), hash);
+    BOOST_CHECK_EQUAL(to_hex(hash, 32), "4d741b6f1eb29cb2a9b9911c82f56fa8d73b04959d3d9d222895df6c0b28aa15");
+
+    // lengths 0 .. 300 cross the 136 bytes blocks, a batch that size refills lanes
+    std::vector<uint8_t> data(300);
+    for (size_t i = 0; i < data.size(); i++) data[i] = (uint8_t)(i * 7 + 3);
+    std::vector<const void *> messages;
+    std::vector<size_t> lengths;
+    for (size_t length = 0; length <= data.size(); length++) {
+        messages.push_back(&data[0]);
+        lengths.push_back(length);
+    }
+    std::vector<uint8_t> hashes(messages.size() * 32);
+    hash::cn_fast_hash_many(&messages[0], &lengths[0], messages.size(), &hashes[0]);
+    char expected[32];
+    for (size_t n = 0; n < messages.size(); n++) {
+        ::cn_fast_hash(&data[0], lengths[n], expected);
+        hash::cn_fast_hash(&data[0], lengths[n], hash);
+        BOOST_CHECK_EQUAL(to_hex(hash, 32), to_hex(expected, 32));
+        BOOST_CHECK_EQUAL(to_hex(&hashes[n * 32], 32), to_hex(expected, 32));
+    }
+}
+
+// tree-hash.c tree_hash on hash.c cn_fast_hash
+static void reference_tree_hash(const uint8_t *hashes, size_t count, char *root) {
+    if (count == 1) {
+        memcpy(root, hashes, 32);
+        return;
+    }
+    size_t cnt = 1;
+    while (cnt * 2 < count) cnt *= 2;
+    std::vector<char> ints(cnt * 32);
+    memcpy(&ints[0], hashes, (2 * cnt - count) * 32);
+    for (size_t i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, j++) {
+        ::cn_fast_hash(hashes + i * 32, 64, &ints[j * 32]);
+    }
+    for (; cnt > 1; cnt /= 2) {
+        for (size_t j = 0; j < cnt / 2; j++) ::cn_fast_hash(&ints[j * 64], 64, &ints[j * 32]);
+    }
+    memcpy(root, &ints[0], 32);
+}
+
+// every tree shape up to 70 transactions and one split over threads, the
+// coinbase replaced after the branch was built
+BOOST_AUTO_TEST_CASE(tree_hash_branch) {
+    using namespace fingera;
+
+    BOOST_CHECK_THROW(hash::tree_hash_branch(nullptr, 0), std::invalid_argument);
+    std::vector<uint8_t> hashes(5000 * 32);
+    for (size_t i = 0; i < hashes.size(); i++) hashes[i] = (uint8_t)(i * 13 + i / 251);
+    std::vector<uint8_t> coinbases(3 * 32);
+    for (size_t i = 0; i < coinbases.size(); i++) coinbases[i] = (uint8_t)(i * 5 + 1);
+
+    std::vector<size_t> counts;
+    for (size_t count = 1; count <= 70; count++) counts.push_back(count);
+    counts.push_back(5000);
+    for (size_t count : counts) {
+        const hash::tree_hash_branch branch(&hashes[0], count, 4);
+        BOOST_CHECK_EQUAL(branch.count(), count);
+        std::vector<uint8_t> leaves(hashes.begin(), hashes.begin() + count * 32);
+        char expected[3][32];
+        uint8_t root[32], roots[3 * 32];
+        for (int n = 0; n < 3; n++) {
+            memcpy(&leaves[0], &coinbases[n * 32], 32);
+            reference_tree_hash(&leaves[0], count, expected[n]);
+            branch.root(&coinbases[n * 32], root);
+            BOOST_CHECK_EQUAL(to_hex(root, 32), to_hex(expected[n], 32));
+        }
+        branch.roots(&coinbases[0], 3, roots);
+        for (int n = 0; n < 3; n++) BOOST_CHECK_EQUAL(to_hex(&roots[n * 32], 32), to_hex(expected[n], 32));
+    }
+}
+
+// shares of a nonce range match single hashes, only those below the target
+BOOST_AUTO_TEST_CASE(cryptonight_scan) {
+    using namespace fingera;
+
+    std::vector<uint8_t> data;
+    BOOST_CHECK(from_hex("0707c3d4a9db055ced477105ab5607d19fa12cf3f538f0e4e724f3bde40ddc05d16a9a068001885b038000b9ba16ee6a563456fc9ec93af68675a295f592992645a54175b375e66e32429e01", data));
+    const uint64_t nonce_begin = 0xfffffffb, nonce_end = (uint64_t)1 << 32;
+    std::vector<std::string> expected;
+    std::vector<uint64_t> tops;
+    for (uint64_t nonce = nonce_begin; nonce != nonce_end; nonce++) {
+        std::vector<uint8_t> blob = data;
+        write_little<uint32_t>(&blob[39], (uint32_t)nonce);
+        uint8_t hash[32];
+        hash::cryptonight("cn-lite/1", &blob[0], blob.size(), hash);
+        expected.push_back(to_hex(hash, 32));
+        tops.push_back(read_little<uint64_t>(hash + 24));
+    }
+    std::vector<uint64_t> sorted = tops;
+    std::sort(sorted.begin(), sorted.end());
+
+    for (int ways = 1; ways <= 5; ways++) {
+        BOOST_TEST_MESSAGE("cryptonight_scan ways " << ways);
+        std::vector<uint32_t> nonces;
+        uint64_t shares = hash::cryptonight_scan("cn-lite/1", &data[0], data.size(), nonce_begin, nonce_end,
+            UINT64_MAX, [&](uint32_t nonce, const void *result) {
+                BOOST_CHECK_EQUAL(to_hex(result, 32), expected[nonce - nonce_begin]);
+                nonces.push_back(nonce);
+            }, ways);
+        BOOST_CHECK_EQUAL(shares, expected.size());
+        BOOST_REQUIRE_EQUAL(nonces.size(), expected.size());
+        for (size_t i = 0; i < nonces.size(); i++) BOOST_CHECK_EQUAL(nonces[i], nonce_begin + i);
+
+        // strictly below: the two smallest of five
+        shares = hash::cryptonight_scan("cn-lite/1", &data[0], data.size(), nonce_begin, nonce_end,
+            sorted[2], [&](uint32_t nonce, const void *) {
+                BOOST_CHECK(tops[nonce - nonce_begin] < sorted[2]);
+            }, ways);
+        BOOST_CHECK_EQUAL(shares, 2);
+    }
+
+    // on_share hashing a bigger variant leaves the scan's scratchpad alone
+    uint8_t v1[32];
+    hash::cryptonight("cn/1", &data[0], data.size(), v1);
+    const std::string expected_v1 = to_hex(v1, 32);
+    BOOST_CHECK_EQUAL(hash::cryptonight_scan("cn-lite/1", &data[0], data.size(), nonce_begin, nonce_end,
+        UINT64_MAX, [&](uint32_t nonce, const void *result) {
+            BOOST_CHECK_EQUAL(to_hex(result, 32), expected[nonce - nonce_begin]);
+            uint8_t hashed[32];
+            hash::cryptonight("cn/1", &data[0], data.size(), hashed);
+            BOOST_CHECK_EQUAL(to_hex(hashed, 32), expected_v1);
+        }), expected.size());
+
+    BOOST_CHECK_EQUAL(hash::cryptonight_scan("cn-lite/1", &data[0], data.size(), 7, 7, UINT64_MAX,
+        [](uint32_t, const void *) { BOOST_FAIL("empty range"); }), 0);
+    BOOST_CHECK_THROW(hash::cryptonight_scan("cn-lite/1", &data[0], 42, 0, 1, 0,
+        [](uint32_t, const void *) {}), std::invalid_argument);
+    BOOST_CHECK_THROW(hash::cryptonight_scan("cn-lite/1", &data[0], data.size(), 0, 1, 0,
+        [](uint32_t, const void *) {}, 6), std::invalid_argument);
+    BOOST_CHECK_THROW(hash::cryptonight_scan("cn-lite/1", &data[0], data.size(), 0, nonce_end + 1, 0,
+        [](uint32_t, const void *) {}), std::invalid_argument);
+}
+
+// monero's tests-slow-4 vectors, the JIT against the interpreter
+BOOST_AUTO_TEST_CASE(cryptonight_r) {
+    using namespace fingera;
+
+    struct {
+        const char *expected;
+        const char *data;
+        uint64_t height;
+    } vectors[] = {
+        {"f759588ad57e758467295443a9bd71490abff8e9dad1b95b6bf2f5d0d78387bc",
+            "5468697320697320612074657374205468697320697320612074657374205468697320697320612074657374", 1806260},
+        {"5bb833deca2bdd7252a9ccd7b4ce0b6a4854515794b56c207262f7a5b9bdb566",
+            "4c6f72656d20697073756d20646f6c6f722073697420616d65742c20636f6e73656374657475722061646970697363696e67", 1806261},
+        {"1ee6728da60fbd8d7d55b2b1ade487a3cf52a2c3ac6f520db12c27d8921f6cab",
+            "656c69742c2073656420646f20656975736d6f642074656d706f7220696e6369646964756e74207574206c61626f7265", 1806262},
+        {"6969fe2ddfb758438d48049f302fc2108a4fcc93e37669170e6db4b0b9b4c4cb",
+            "657420646f6c6f7265206d61676e6120616c697175612e20557420656e696d206164206d696e696d2076656e69616d2c", 1806263},
+        {"7f3048b4e90d0cbe7a57c0394f37338a01fae3adfdc0e5126d863a895eb04e02",
+            "71756973206e6f737472756420657865726369746174696f6e20756c6c616d636f206c61626f726973206e697369", 1806264},
+        {"1d290443a4b542af04a82f6b2494a6ee7f20f2754c58e0849032483a56e8e2ef",
+            "757420616c697175697020657820656120636f6d6d6f646f20636f6e7365717561742e20447569732061757465", 1806265},
+        {"c43cc6567436a86afbd6aa9eaa7c276e9806830334b614b2bee23cc76634f6fd",
+            "697275726520646f6c6f7220696e20726570726568656e646572697420696e20766f6c7570746174652076656c6974", 1806266},
+        {"87be2479c0c4e8edfdfaa5603e93f4265b3f8224c1c5946feb424819d18990a4",
+            "657373652063696c6c756d20646f6c6f726520657520667567696174206e756c6c612070617269617475722e", 1806267},
+        {"dd9d6a6d8e47465cceac0877ef889b93e7eba979557e3935d7f86dce11b070f3",
+            "4578636570746575722073696e74206f6363616563617420637570696461746174206e6f6e2070726f6964656e742c", 1806268},
+        {"75c6f2ae49a20521de97285b431e717125847fb8935ed84a61e7f8d36a2c3d8e",
+            "73756e7420696e2063756c706120717569206f666669636961206465736572756e74206d6f6c6c697420616e696d20696420657374206c61626f72756d2e", 1806269},
+    };
+    char hash[32];
+    hugepage_buffer scratchpad(hash::monero_scratchpad_size);
+    for (auto &v : vectors) {
+        std::vector<uint8_t> data;
+        BOOST_REQUIRE(from_hex(v.data, data));
+        hash::cryptonight_r_program program(v.height);
+        BOOST_CHECK(program.size() >= 60 && program.size() <= hash::cryptonight_r_program::max_size);
+        BOOST_CHECK_EQUAL(program.code()[program.size()].opcode, hash::cryptonight_r_program::ret);
+        for (auto backend : dispatch::monero_backends()) {
+            BOOST_TEST_MESSAGE("cn/r " << backend->name << " height " << v.height);
+            memset(hash, 0, sizeof(hash));
+            backend->cn_r(&data[0], data.size(), hash, scratchpad.data(), program);
+            BOOST_CHECK_EQUAL(to_hex(hash, 32), v.expected);
+        }
+        hash::cryptonight_r(program, &data[0], data.size(), hash);
+        BOOST_CHECK_EQUAL(to_hex(hash, 32), v.expected);
+        hash::cryptonight_r_program interpreted(v.height, false);
+        memset(hash, 0, sizeof(hash));
+        hash::cryptonight_r(interpreted, &data[0], data.size(), hash);
+        BOOST_CHECK_EQUAL(to_hex(hash, 32), v.expected);
+    }
+
+    uint32_t seed = 1;
+    for (uint64_t height = 1806260; height < 1806260 + 100; height++) {
+        hash::cryptonight_r_program compiled(height), interpreted(height, false);
+        BOOST_CHECK(interpreted.native() == nullptr);
+        BOOST_REQUIRE_EQUAL(compiled.size(), interpreted.size());
+        for (int k = 0; k < 4; k++) {
+            uint32_t r1[9], r2[9];
+            for (int i = 0; i < 9; i++) {
+                seed = seed * 1103515245 + 12345;
+                r1[i] = r2[i] = seed;
+            }
+            compiled.run(r1);
+            interpreted.run(r2);
+            BOOST_CHECK(memcmp(r1, r2, sizeof(r1)) == 0);
+        }
+    }
+}
+
+// the stack key schedule matches the one oaes_key_import_data builds
+BOOST_AUTO_TEST_CASE(aesb_expand_key) {
+    uint8_t key[32];
+    for (int n = 0; n < 3; n++) {
+        for (size_t i = 0; i < sizeof(key); i++) key[i] = (uint8_t)(i * 29 + n * 101 + 5);
+        uint8_t expanded[240];
+        ::aesb_expand_key(key, expanded);
+
+        OAES_CTX *ctx = oaes_alloc();
+        BOOST_REQUIRE(ctx);
+        BOOST_REQUIRE_EQUAL(oaes_key_import_data(ctx, key, sizeof(key)), OAES_RET_SUCCESS);
+        const oaes_key *reference = ((oaes_ctx *)ctx)->key;
+        BOOST_REQUIRE_EQUAL(reference->exp_data_len, sizeof(expanded));
+        BOOST_CHECK_EQUAL(fingera::to_hex(expanded, sizeof(expanded)),
+            fingera::to_hex(reference->exp_data, reference->exp_data_len));
+        oaes_free(&ctx);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,11 +3,20 @@
 #include <boost/test/unit_test.hpp>
 
 #include <iostream>
+#include <vector>
 #include <fingera/config.hpp>
 #include <fingera/multiway_integer.hpp>
 #include <fingera/hex.hpp>
-#include <fingera/instrinsic/mi_sse2.hpp>
-#include <fingera/instrinsic/mi_avx2.hpp>
+#include <fingera/cpu_features.hpp>
+#include "multiway_sha256_checks.hpp"
+
+boost::test_tools::assertion_result cpu_supports::operator()(boost::unit_test::test_unit_id) const {
+    std::unordered_map<std::string, bool> features;
+    fingera::get_cpu_features(features);
+    boost::test_tools::assertion_result result(features[feature]);
+    if (!result) result.message() << "the cpu lacks " << feature;
+    return result;
+}
 
 BOOST_AUTO_TEST_SUITE(multiway_sha256_tests)
 
@@ -151,14 +160,6 @@ BOOST_AUTO_TEST_CASE(base) {
         BOOST_CHECK_EQUAL(to_hex(result + 32, 32), hashes[i * 2 + 1]);
     }
     for (size_t i = 0; i < 2; i++) {
-#if defined(FINGERA_USE_SSE2)
-        memset(result, 0, sizeof(result));
-        hash::multiway_sha256<instrinsic::mi_sse2>::process_trunk(result, sha256_blocks + i * 64 * 4);
-        BOOST_CHECK_EQUAL(to_hex(result, 32), hashes[i * 4]);
-        BOOST_CHECK_EQUAL(to_hex(result + 32 * 1, 32), hashes[i * 4 + 1]);
-        BOOST_CHECK_EQUAL(to_hex(result + 32 * 2, 32), hashes[i * 4 + 2]);
-        BOOST_CHECK_EQUAL(to_hex(result + 32 * 3, 32), hashes[i * 4 + 3]);
-#endif
         memset(result, 0, sizeof(result));
         hash::multiway_sha256<multiway_integer_slow<uint32_t, 4>>::process_trunk(result, sha256_blocks + i * 64 * 4);
         BOOST_CHECK_EQUAL(to_hex(result, 32), hashes[i * 4]);
@@ -166,14 +167,40 @@ BOOST_AUTO_TEST_CASE(base) {
         BOOST_CHECK_EQUAL(to_hex(result + 32 * 2, 32), hashes[i * 4 + 2]);
         BOOST_CHECK_EQUAL(to_hex(result + 32 * 3, 32), hashes[i * 4 + 3]);
     }
+}
 
-#if defined(FINGERA_USE_AVX2)
-    memset(result, 0, sizeof(result));
-    hash::multiway_sha256<instrinsic::mi_avx2>::process_trunk(result, sha256_blocks);
-    for (size_t i = 0; i < 8; i++) {
-        BOOST_CHECK_EQUAL(to_hex(result + 32 * i, 32), hashes[i]);
+BOOST_AUTO_TEST_CASE(process_block_h) {
+    using namespace fingera;
+
+    uint8_t blocks[8 * 64];
+    for (size_t i = 0; i < sizeof(blocks); i++) {
+        blocks[i] = (uint8_t)(i * 131 + 7);
+    }
+    check_process_block_h<multiway_integer<uint32_t, uint32_t>>(blocks);
+    check_process_block_h<multiway_integer<uint32_t, uint64_t>>(blocks);
+    check_process_block_h<multiway_integer_slow<uint32_t, 8>>(blocks);
+}
+
+BOOST_AUTO_TEST_CASE(process_trunk_lanes) {
+    using namespace fingera;
+
+    uint8_t blocks[3 * 16 * 64];
+    for (size_t i = 0; i < sizeof(blocks); i++) {
+        blocks[i] = (uint8_t)(i * 73 + 11);
+    }
+    check_process_trunk_lanes<multiway_integer<uint32_t, uint32_t>>(blocks, 3);
+    check_process_trunk_lanes<multiway_integer<uint32_t, uint64_t>>(blocks, 3);
+    check_process_trunk_lanes<multiway_integer_slow<uint32_t, 8>>(blocks, 3);
+}
+
+BOOST_AUTO_TEST_CASE(process_block_const) {
+    using namespace fingera;
+
+    uint8_t blocks[16 * 64];
+    for (size_t i = 0; i < sizeof(blocks); i++) {
+        blocks[i] = (uint8_t)(i * 53 + 3);
     }
-#endif
+    check_process_block_const<multiway_integer<uint32_t, uint32_t>>(blocks);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
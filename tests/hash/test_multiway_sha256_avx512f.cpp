@@ -0,0 +1,19 @@
+#include <fingera/config.hpp>
+// compiled with -mavx512f (tests/CMakeLists.txt), whatever the build host detected
+#if !defined(FINGERA_USE_AVX512F)
+#define FINGERA_USE_AVX512F
+#endif
+#include <fingera/instrinsic/mi_avx512.hpp>
+#include "multiway_sha256_checks.hpp"
+
+BOOST_AUTO_TEST_SUITE(multiway_sha256_tests)
+
+BOOST_AUTO_TEST_CASE(avx512f, *boost::unit_test::precondition(cpu_supports{"avx512f"})) {
+    uint8_t blocks[3 * 16 * 64];
+    for (size_t i = 0; i < sizeof(blocks); i++) {
+        blocks[i] = (uint8_t)(i * 73 + 11);
+    }
+    check_multiway_sha256<fingera::instrinsic::mi_avx512>(blocks);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
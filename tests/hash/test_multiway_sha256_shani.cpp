@@ -0,0 +1,28 @@
+#include <fingera/config.hpp>
+// compiled with -msha -msse4.1 (tests/CMakeLists.txt), whatever the build host detected
+#if !defined(FINGERA_USE_SHA)
+#define FINGERA_USE_SHA
+#endif
+#include <fingera/hash/sha256_shani.hpp>
+#include "multiway_sha256_checks.hpp"
+
+BOOST_AUTO_TEST_SUITE(multiway_sha256_tests)
+
+// the single buffer engine against the one way scalar one
+BOOST_AUTO_TEST_CASE(shani, *boost::unit_test::precondition(cpu_supports{"sha"}) *
+        boost::unit_test::precondition(cpu_supports{"sse4.1"})) {
+    using namespace fingera;
+
+    uint8_t blocks[3 * 64];
+    for (size_t i = 0; i < sizeof(blocks); i++) {
+        blocks[i] = (uint8_t)(i * 73 + 11);
+    }
+    for (int count = 1; count <= 3; count++) {
+        uint8_t expected[32], result[32];
+        hash::multiway_sha256<multiway_integer<uint32_t, uint32_t>>::process_trunk(expected, blocks, count);
+        hash::sha256_shani::process_trunk(result, blocks, count);
+        BOOST_CHECK_EQUAL(to_hex(result, 32), to_hex(expected, 32));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,19 @@
+#include <fingera/config.hpp>
+// compiled with -msse2 (tests/CMakeLists.txt), whatever the build host detected
+#if !defined(FINGERA_USE_SSE2)
+#define FINGERA_USE_SSE2
+#endif
+#include <fingera/instrinsic/mi_sse2.hpp>
+#include "multiway_sha256_checks.hpp"
+
+BOOST_AUTO_TEST_SUITE(multiway_sha256_tests)
+
+BOOST_AUTO_TEST_CASE(sse2, *boost::unit_test::precondition(cpu_supports{"sse2"})) {
+    uint8_t blocks[3 * 16 * 64];
+    for (size_t i = 0; i < sizeof(blocks); i++) {
+        blocks[i] = (uint8_t)(i * 73 + 11);
+    }
+    check_multiway_sha256<fingera::instrinsic::mi_sse2>(blocks);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+#include <fingera/hash/sha256.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fingera/dispatch.hpp>
+#include <fingera/endian.hpp>
+#include <fingera/hex.hpp>
+#include <fingera/multiway_integer.hpp>
+#include <fingera/hash/multiway_sha256.hpp>
+
+BOOST_AUTO_TEST_SUITE(sha256_tests)
+
+static std::string reference_sha256(const std::vector<uint8_t> &message) {
+    using sha256 = fingera::hash::multiway_sha256<fingera::multiway_integer<uint32_t, uint32_t>>;
+    std::vector<uint8_t> blocks(message);
+    blocks.push_back(0x80);
+    while (blocks.size() % 64 != 56) blocks.push_back(0);
+    blocks.resize(blocks.size() + 8);
+    fingera::write_big<uint64_t>(&blocks[blocks.size() - 8], (uint64_t)message.size() * 8);
+    uint8_t digest[32];
+    sha256::process_trunk(digest, &blocks[0], (int)(blocks.size() / 64));
+    return fingera::to_hex(digest, 32);
+}
+
+BOOST_AUTO_TEST_CASE(known) {
+    using namespace fingera;
+
+    std::vector<std::vector<uint8_t>> data = {
+        {},
+        {'a', 'b', 'c'},
+        std::vector<uint8_t>(1000000, 'a'),
+    };
+    const char *abcd = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    data.emplace_back(abcd, abcd + strlen(abcd));
+    std::vector<const void *> messages;
+    std::vector<size_t> lengths;
+    for (auto &d : data) {
+        messages.push_back(d.data());
+        lengths.push_back(d.size());
+    }
+    std::vector<uint8_t> out(32 * data.size());
+    hash::sha256_many(messages, lengths, out);
+    BOOST_CHECK_EQUAL(to_hex(&out[0], 32), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    BOOST_CHECK_EQUAL(to_hex(&out[32], 32), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    BOOST_CHECK_EQUAL(to_hex(&out[64], 32), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    BOOST_CHECK_EQUAL(to_hex(&out[96], 32), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    BOOST_CHECK_THROW(hash::sha256_many(messages, lengths, span<uint8_t>(&out[0], 32)), std::range_error);
+}
+
+// every length around the padding boundaries, mixed so lanes refill at different times
+BOOST_AUTO_TEST_CASE(mixed_lengths) {
+    using namespace fingera;
+
+    std::vector<std::vector<uint8_t>> data;
+    for (size_t len = 0; len < 300; len++) {
+        size_t n = (len * 37) % 300;
+        std::vector<uint8_t> d(n);
+        for (size_t i = 0; i < n; i++) {
+            d[i] = (uint8_t)(i * 7 + len);
+        }
+        data.push_back(d);
+    }
+    std::vector<const void *> messages;
+    std::vector<size_t> lengths;
+    for (auto &d : data) {
+        messages.push_back(d.data());
+        lengths.push_back(d.size());
+    }
+    for (auto backend : dispatch::sha256_backends()) {
+        BOOST_TEST_MESSAGE("process_many backend " << backend->name);
+        std::vector<uint8_t> out(32 * data.size());
+        backend->process_many(&messages[0], &lengths[0], messages.size(), &out[0]);
+        for (size_t n = 0; n < data.size(); n++) {
+            BOOST_CHECK_EQUAL(to_hex(&out[32 * n], 32), reference_sha256(data[n]));
+        }
+        // fewer messages than lanes
+        std::fill(out.begin(), out.end(), 0);
+        backend->process_many(&messages[1], &lengths[1], 1, &out[0]);
+        BOOST_CHECK_EQUAL(to_hex(&out[0], 32), reference_sha256(data[1]));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,188 @@
+#include <fingera/hash/sha256d.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <fingera/dispatch.hpp>
+#include <fingera/endian.hpp>
+#include <fingera/hex.hpp>
+#include <fingera/multiway_integer.hpp>
+#include <fingera/hash/multiway_sha256.hpp>
+
+BOOST_AUTO_TEST_SUITE(sha256d_tests)
+
+// bitcoin genesis block, nonce 2083236893
+static const char *genesis_header =
+    "01000000"
+    "0000000000000000000000000000000000000000000000000000000000000000"
+    "3ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa4b1e5e4a"
+    "29ab5f49" "ffff001d" "1dac2b7c";
+
+// sha256d of an 80 bytes header, little endian uint256
+static void reference_sha256d(const uint8_t *header, uint8_t *hash) {
+    using sha256 = fingera::hash::multiway_sha256<fingera::multiway_integer<uint32_t, uint32_t>>;
+    uint8_t blocks[128] = {0};
+    memcpy(blocks, header, 80);
+    blocks[80] = 0x80;
+    blocks[126] = 0x02;
+    blocks[127] = 0x80;
+    uint8_t digest[32];
+    sha256::process_trunk(digest, blocks, 2);
+    uint8_t block[64] = {0};
+    memcpy(block, digest, 32);
+    block[32] = 0x80;
+    block[62] = 0x01;
+    sha256::process_trunk(hash, block, 1);
+}
+
+BOOST_AUTO_TEST_CASE(genesis) {
+    using namespace fingera;
+
+    std::vector<uint8_t> header;
+    BOOST_REQUIRE(from_hex(genesis_header, header));
+    uint8_t hash[32];
+    reference_sha256d(&header[0], hash);
+    std::reverse(hash, hash + 32);
+    BOOST_CHECK_EQUAL(to_hex(hash, 32), "000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f");
+
+    // bits 0x1d00ffff
+    uint8_t target[32] = {0};
+    target[26] = 0xff;
+    target[27] = 0xff;
+    const uint32_t nonce = 2083236893u;
+
+    std::vector<uint32_t> found = hash::scan_nonces(&header[0], nonce - 1000, 2001, target);
+    BOOST_REQUIRE_EQUAL(found.size(), 1);
+    BOOST_CHECK_EQUAL(found[0], nonce);
+
+    for (auto backend : dispatch::sha256_backends()) {
+        BOOST_TEST_MESSAGE("scan_nonces backend " << backend->name);
+        uint32_t hits[4];
+        BOOST_CHECK_EQUAL(backend->scan_nonces(&header[0], nonce - 37, 75, target, hits, 4), 1);
+        BOOST_CHECK_EQUAL(hits[0], nonce);
+        // the nonce itself is the last one scanned
+        BOOST_CHECK_EQUAL(backend->scan_nonces(&header[0], nonce - 36, 37, target, hits, 4), 1);
+        BOOST_CHECK_EQUAL(backend->scan_nonces(&header[0], nonce - 36, 36, target, hits, 4), 0);
+
+        // just below the genesis hash
+        uint8_t tight[32];
+        reference_sha256d(&header[0], tight);
+        BOOST_CHECK_EQUAL(backend->scan_nonces(&header[0], nonce, 1, tight, hits, 4), 1);
+        for (int i = 0; i < 32; i++) {
+            if (tight[i]--) break;
+        }
+        BOOST_CHECK_EQUAL(backend->scan_nonces(&header[0], nonce, 1, tight, hits, 4), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(every_nonce) {
+    using namespace fingera;
+
+    std::vector<uint8_t> header;
+    BOOST_REQUIRE(from_hex(genesis_header, header));
+
+    // only the top 32 bits below 0x40000000, about a quarter of the nonces
+    uint8_t target[32];
+    memset(target, 0xff, sizeof(target));
+    target[31] = 0x3f;
+
+    // crosses 0xffffffff => 0 and ends in a partial batch
+    const uint32_t start = 0xffffffe0u;
+    const uint64_t count = 77;
+    std::vector<uint32_t> expected;
+    for (uint64_t i = 0; i < count; i++) {
+        uint32_t nonce = start + (uint32_t)i;
+        write_little<uint32_t>(&header[76], nonce);
+        uint8_t hash[32];
+        reference_sha256d(&header[0], hash);
+        if (hash[31] <= 0x3f) expected.push_back(nonce);
+    }
+    BOOST_REQUIRE(!expected.empty());
+
+    for (auto backend : dispatch::sha256_backends()) {
+        BOOST_TEST_MESSAGE("scan_nonces backend " << backend->name);
+        std::vector<uint32_t> found(count);
+        size_t hits = backend->scan_nonces(&header[0], start, count, target, &found[0], found.size());
+        found.resize(hits);
+        BOOST_CHECK_EQUAL_COLLECTIONS(found.begin(), found.end(), expected.begin(), expected.end());
+    }
+}
+
+// sha256d of every 64 bytes pair, one pair at a time
+static std::vector<uint8_t> reference_merkle_root(std::vector<uint8_t> level) {
+    using sha256 = fingera::hash::multiway_sha256<fingera::multiway_integer<uint32_t, uint32_t>>;
+    if (level.empty()) return std::vector<uint8_t>(32, 0);
+    while (level.size() > 32) {
+        if (level.size() % 64) {
+            level.resize(level.size() + 32);
+            memcpy(&level[level.size() - 32], &level[level.size() - 64], 32);
+        }
+        std::vector<uint8_t> next;
+        for (size_t i = 0; i < level.size(); i += 64) {
+            uint8_t blocks[128] = {0};
+            memcpy(blocks, &level[i], 64);
+            blocks[64] = 0x80;
+            blocks[126] = 0x02;
+            uint8_t digest[32];
+            sha256::process_trunk(digest, blocks, 2);
+            uint8_t block[64] = {0};
+            memcpy(block, digest, 32);
+            block[32] = 0x80;
+            block[62] = 0x01;
+            sha256::process_trunk(digest, block, 1);
+            next.insert(next.end(), digest, digest + 32);
+        }
+        level.swap(next);
+    }
+    return level;
+}
+
+BOOST_AUTO_TEST_CASE(merkle_root) {
+    using namespace fingera;
+
+    // block 100000
+    const char *txids[] = {
+        "8c14f0db3df150123e6f3dbbf30f8b955a8249b62ac1d1ff16284aefa3d06d87",
+        "fff2525b8931402dd09222c50775608f75787bd2b87e56995a7bdd30f79702c4",
+        "6359f0868171b1d194cbee1af2f16ea598ae8fad666d9b012c8ed2b79a236ec4",
+        "e9a66845e05d5abc0ad04ec80f774a7e585c6e8db975962d069a522137b80c1d",
+    };
+    std::vector<uint8_t> leaves;
+    for (auto txid : txids) {
+        std::vector<uint8_t> hash;
+        BOOST_REQUIRE(from_hex(txid, hash));
+        leaves.insert(leaves.end(), hash.rbegin(), hash.rend());
+    }
+    uint8_t root[32];
+    hash::merkle_root(leaves, root);
+    std::reverse(root, root + 32);
+    BOOST_CHECK_EQUAL(to_hex(root, 32), "f3e94742aca4b5ef85488dc37c06c3282295ffec960994b2c0d5ac2a25a95766");
+
+    std::vector<uint8_t> odd(32 * 5000);
+    for (size_t i = 0; i < odd.size(); i++) {
+        odd[i] = (uint8_t)(i * 29 + i / 32);
+    }
+    for (size_t count : {0, 1, 2, 3, 7, 17, 33, 5000}) {
+        std::vector<uint8_t> part(odd.begin(), odd.begin() + count * 32);
+        std::vector<uint8_t> expected = reference_merkle_root(part);
+        hash::merkle_root(part, root);
+        BOOST_CHECK_EQUAL(to_hex(root, 32), to_hex(&expected[0], 32));
+        hash::merkle_root(part, root, 4);
+        BOOST_CHECK_EQUAL(to_hex(root, 32), to_hex(&expected[0], 32));
+    }
+
+    for (auto backend : dispatch::sha256_backends()) {
+        BOOST_TEST_MESSAGE("sha256d_64 backend " << backend->name);
+        std::vector<uint8_t> out(32 * 37);
+        backend->sha256d_64(&out[0], &odd[0], 37);
+        for (size_t i = 0; i < 37; i++) {
+            std::vector<uint8_t> pair(odd.begin() + i * 64, odd.begin() + i * 64 + 64);
+            BOOST_CHECK_EQUAL(to_hex(&out[i * 32], 32), to_hex(&reference_merkle_root(pair)[0], 32));
+        }
+    }
+
+    BOOST_CHECK_THROW(hash::merkle_root(span<const uint8_t>(&odd[0], 33), root), std::range_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+#include <fingera/cpu_features.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <map>
+
+BOOST_AUTO_TEST_SUITE(cpu_features_tests)
+
+// decode_cpu_features on synthetic leaves: an AVX2 + VAES cpu, then the
+// same with AVX2 masked (as some hypervisors do), then without YMM state
+BOOST_AUTO_TEST_CASE(decode_vaes) {
+    using namespace fingera;
+
+    cpuid_leaves leaves = {};
+    leaves.max_level = 7;
+    leaves.leaf1_cx = (1u << 25) | (1u << 27) | (1u << 28);    // aes osxsave avx
+    leaves.leaf1_dx = 1u << 26;                                 // sse2
+    leaves.xcr0 = 0x7;                                          // x87 sse ymm
+    leaves.leaf7_bx = 1u << 5;                                  // avx2
+    leaves.leaf7_cx = 1u << 9;                                  // vaes
+
+    std::unordered_map<std::string, bool> features;
+    BOOST_REQUIRE(decode_cpu_features(leaves, features));
+    BOOST_CHECK(features["aes"]);
+    BOOST_CHECK(features["avx2"]);
+    BOOST_CHECK(features["vaes"]);
+    BOOST_CHECK(!features["avx512f"]);
+
+    leaves.leaf7_bx &= ~(1u << 5);
+    features.clear();
+    BOOST_REQUIRE(decode_cpu_features(leaves, features));
+    BOOST_CHECK(features["avx"]);
+    BOOST_CHECK(!features["avx2"]);
+    BOOST_CHECK(!features["vaes"]);
+
+    leaves.leaf7_bx |= 1u << 5;
+    leaves.xcr0 = 0x3;
+    features.clear();
+    BOOST_REQUIRE(decode_cpu_features(leaves, features));
+    BOOST_CHECK(!features["avx2"]);
+    BOOST_CHECK(!features["vaes"]);
+
+    leaves.max_level = 0;
+    BOOST_CHECK(!decode_cpu_features(leaves, features));
+}
+
+// cores partition the cpus, every cache level covers each cpu once
+BOOST_AUTO_TEST_CASE(topology) {
+    using namespace fingera;
+
+    cpu_topology topology;
+    BOOST_REQUIRE(get_cpu_topology(topology));
+    BOOST_TEST_MESSAGE("cpus " << topology.cpus.size() << " cores " << topology.cores.size() <<
+        " caches " << topology.caches.size() << " sysfs_mismatch " << topology.sysfs_mismatch);
+    BOOST_REQUIRE(!topology.cpus.empty());
+    BOOST_CHECK(std::is_sorted(topology.cpus.begin(), topology.cpus.end()));
+
+    std::map<int, int> cores;
+    for (const cpu_core &core : topology.cores) {
+        BOOST_REQUIRE(!core.cpus.empty());
+        BOOST_CHECK(std::is_sorted(core.cpus.begin(), core.cpus.end()));
+        BOOST_CHECK(topology.hybrid || core.type == cpu_core::unknown);
+        for (int cpu : core.cpus) cores[cpu]++;
+    }
+    BOOST_CHECK_EQUAL(cores.size(), topology.cpus.size());
+    for (int cpu : topology.cpus) BOOST_CHECK_EQUAL(cores[cpu], 1);
+
+    std::map<std::pair<int, int>, std::map<int, int>> caches;
+    for (const cpu_cache &cache : topology.caches) {
+        BOOST_TEST_MESSAGE("L" << cache.level << " type " << cache.type << " " << cache.size << " bytes, " <<
+            cache.cpus.size() << " cpus");
+        BOOST_CHECK_GE(cache.level, 1);
+        BOOST_CHECK_GT(cache.size, 0);
+        BOOST_REQUIRE(!cache.cpus.empty());
+        for (int cpu : cache.cpus) caches[std::make_pair(cache.level, (int)cache.type)][cpu]++;
+    }
+    for (auto &level : caches) {
+        BOOST_CHECK_EQUAL(level.second.size(), topology.cpus.size());
+        for (auto &cpu : level.second) BOOST_CHECK_EQUAL(cpu.second, 1);
+    }
+
+    // nodes, when known, partition the cpus too
+    std::map<int, int> nodes;
+    for (const cpu_node &node : topology.nodes) {
+        BOOST_CHECK(std::is_sorted(node.cpus.begin(), node.cpus.end()));
+        for (int cpu : node.cpus) {
+            nodes[cpu]++;
+            BOOST_CHECK_EQUAL(topology.node_of(cpu), node.id);
+        }
+    }
+    BOOST_CHECK(nodes.empty() || nodes.size() == topology.cpus.size());
+    for (auto &cpu : nodes) BOOST_CHECK_EQUAL(cpu.second, 1);
+    BOOST_CHECK_EQUAL(topology.node_of(-1), -1);
+
+    const int last = topology.last_level();
+    if (last) {
+        BOOST_CHECK_GT(topology.cache_size(last), 0);
+        BOOST_CHECK_GE(topology.total_cache_size(last), topology.cache_size(last));
+    }
+    BOOST_CHECK_EQUAL(topology.cache_size(last + 1), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
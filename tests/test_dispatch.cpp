@@ -0,0 +1,190 @@
+#include <fingera/dispatch.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <fingera/cpu_features.hpp>
+#include <fingera/endian.hpp>
+#include <fingera/hex.hpp>
+#include <fingera/hugepages.hpp>
+#include <fingera/hash/monero.hpp>
+
+BOOST_AUTO_TEST_SUITE(dispatch_tests)
+
+// get_cpu_features reports every space separated key of a backend's feature
+static bool cpu_has(const char *feature) {
+    std::unordered_map<std::string, bool> features;
+    fingera::get_cpu_features(features);
+    std::istringstream keys(feature ? feature : "");
+    std::string key;
+    while (keys >> key) {
+        if (!features[key]) return false;
+    }
+    return true;
+}
+
+// every lane hashes sha256("0" + lane % 8) then the 2-block "abcdbcde...nopq"
+static void check_sha256_backend(const fingera::dispatch::sha256_backend *backend) {
+    using namespace fingera;
+
+    BOOST_TEST_MESSAGE("sha256 backend " << backend->name);
+    std::string hashes[] = {
+        "5feceb66ffc86f38d952786c6d696c79c2dbc239dd4e91b46729d73a27fb57e9",
+        "6b86b273ff34fce19d6b804eff5a3f5747ada4eaa22f1d49c01e52ddb7875b4b",
+        "d4735e3a265e16eee03f59718b9b5d03019c07d8b6c51f90da3a666eec13ab35",
+        "4e07408562bedb8b60ce05c1decfe3ad16b72230967de01f640b7e4729b49fce",
+        "4b227777d4dd1fc61c6f884f48641d02b4d121d3fd328cb08b5531fcacdabf8a",
+        "ef2d127de37b942baad06145e54b0c619a1f22327b2ebbcfbec78f5564afe39d",
+        "e7f6c011776e8db7cd330b54174fd76f7d0216b612387a5ffcfb81e6f0919683",
+        "7902699be42c8a8e46fbbb4501726517e86b22c56a189f7625a6da49081b2451",
+    };
+    std::vector<uint8_t> blocks(backend->way * 64 * 2, 0);
+    std::vector<uint8_t> result(backend->way * 32, 0);
+    for (int i = 0; i < backend->way; i++) {
+        blocks[i * 64] = '0' + i % 8;
+        blocks[i * 64 + 1] = 0x80;
+        blocks[i * 64 + 63] = 0x08;
+    }
+    backend->process_trunk(&result[0], &blocks[0], 1);
+    for (int i = 0; i < backend->way; i++) {
+        BOOST_CHECK_EQUAL(to_hex(&result[i * 32], 32), hashes[i % 8]);
+    }
+
+    // lane-major: word j of lane i is the little endian uint32_t at (j * way + i) * 4
+    if (backend->process_trunk_lanes) {
+        std::vector<uint8_t> lanes(backend->way * 64, 0);
+        std::vector<uint8_t> state(backend->way * 32, 0);
+        for (int i = 0; i < backend->way; i++) {
+            lanes[i * 4 + 3] = '0' + i % 8;
+            lanes[i * 4 + 2] = 0x80;
+            lanes[(15 * backend->way + i) * 4] = 0x08;
+        }
+        backend->process_trunk_lanes(&state[0], &lanes[0], 1);
+        for (int i = 0; i < backend->way; i++) {
+            uint8_t digest[32];
+            for (int j = 0; j < 8; j++) {
+                write_big<uint32_t>(digest + j * 4, read_little<uint32_t>(&state[(j * backend->way + i) * 4]));
+            }
+            BOOST_CHECK_EQUAL(to_hex(digest, 32), hashes[i % 8]);
+        }
+    }
+
+    // blocks are interleaved: block 0 of every lane, then block 1 of every lane
+    const char *message = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    std::fill(blocks.begin(), blocks.end(), 0);
+    for (int i = 0; i < backend->way; i++) {
+        memcpy(&blocks[i * 64], message, 56);
+        blocks[i * 64 + 56] = 0x80;
+        blocks[backend->way * 64 + i * 64 + 62] = 0x01;
+        blocks[backend->way * 64 + i * 64 + 63] = 0xc0;
+    }
+    backend->process_trunk(&result[0], &blocks[0], 2);
+    for (int i = 0; i < backend->way; i++) {
+        BOOST_CHECK_EQUAL(to_hex(&result[i * 32], 32), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sha256) {
+    using namespace fingera;
+
+    const auto &backends = dispatch::sha256_backends();
+    BOOST_REQUIRE(!backends.empty());
+    BOOST_CHECK_EQUAL(&dispatch::sha256(), backends.front());
+    BOOST_CHECK_EQUAL(backends.back()->name, "generic");
+    for (auto backend : backends) {
+        BOOST_CHECK(cpu_has(backend->feature));
+        check_sha256_backend(backend);
+    }
+
+    const auto &singles = dispatch::sha256_single_backends();
+    BOOST_REQUIRE(!singles.empty());
+    BOOST_CHECK_EQUAL(&dispatch::sha256_single(), singles.front());
+    for (auto backend : singles) {
+        BOOST_CHECK_EQUAL(backend->way, 1);
+        BOOST_CHECK(cpu_has(backend->feature));
+        check_sha256_backend(backend);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(monero) {
+    using namespace fingera;
+
+    const auto &backends = dispatch::monero_backends();
+    BOOST_REQUIRE(!backends.empty());
+    BOOST_CHECK_EQUAL(&dispatch::monero(), backends.front());
+
+    std::vector<uint8_t> data;
+    char hash[32];
+    BOOST_CHECK(from_hex("0707c3d4a9db055ced477105ab5607d19fa12cf3f538f0e4e724f3bde40ddc05d16a9a068001885b038000b9ba16ee6a563456fc9ec93af68675a295f592992645a54175b375e66e32429e01", data));
+    hash::monero_standard(&data[0], data.size(), hash);
+    std::string expected = to_hex(hash, 32);
+    // one nonce per lane, so lanes sharing registers cannot mix
+    std::vector<std::vector<uint8_t>> nonces(5, data);
+    std::vector<std::string> expected_nonces;
+    for (int i = 0; i < 5; i++) {
+        nonces[i][39] ^= (uint8_t)(i + 1);
+        hash::monero_standard(&nonces[i][0], nonces[i].size(), hash);
+        expected_nonces.push_back(to_hex(hash, 32));
+    }
+    hugepage_buffer scratchpad(hash::monero_scratchpad_size * 5);
+    for (auto backend : backends) {
+        BOOST_TEST_MESSAGE("monero backend " << backend->name);
+        memset(hash, 0, sizeof(hash));
+        backend->cpu_fast(&data[0], data.size(), hash, scratchpad.data());
+        BOOST_CHECK_EQUAL(to_hex(hash, 32), expected);
+
+        for (int n = 1; n <= 5; n++) {
+            std::vector<char> hashes(n * 32, 0);
+            std::vector<const void *> blobs(n, &data[0]);
+            std::vector<size_t> lengths(n, data.size());
+            std::vector<void *> results(n);
+            for (int i = 0; i < n; i++) {
+                results[i] = &hashes[i * 32];
+            }
+            backend->cpu_fast_multi[n - 1](&blobs[0], &lengths[0], &results[0], scratchpad.data());
+            for (int i = 0; i < n; i++) {
+                BOOST_CHECK_EQUAL(to_hex(&hashes[i * 32], 32), expected);
+            }
+
+            for (int i = 0; i < n; i++) {
+                blobs[i] = &nonces[i][0];
+            }
+            backend->cpu_fast_multi[n - 1](&blobs[0], &lengths[0], &results[0], scratchpad.data());
+            for (int i = 0; i < n; i++) {
+                BOOST_CHECK_EQUAL(to_hex(&hashes[i * 32], 32), expected_nonces[i]);
+            }
+        }
+    }
+}
+
+// every lane of every backend against the single state portable one
+BOOST_AUTO_TEST_CASE(keccak) {
+    using namespace fingera;
+
+    const auto &backends = dispatch::keccak_backends();
+    BOOST_REQUIRE(!backends.empty());
+    BOOST_CHECK_EQUAL(&dispatch::keccak(), backends.front());
+    const dispatch::keccak_backend *reference = backends.back();
+    BOOST_REQUIRE_EQUAL(reference->name, std::string("portable"));
+
+    for (auto backend : backends) {
+        BOOST_TEST_MESSAGE("keccak backend " << backend->name);
+        std::vector<uint64_t> states(backend->way * 25), expected(backend->way * 25);
+        std::vector<uint64_t *> lanes(backend->way);
+        for (size_t i = 0; i < states.size(); i++) states[i] = expected[i] = i * 0x9e3779b97f4a7c15ull;
+        for (int k = 0; k < backend->way; k++) lanes[k] = &states[k * 25];
+        // twice, the second permutation starting from the first one's output
+        for (int round = 0; round < 2; round++) {
+            backend->keccakf(&lanes[0]);
+            for (int k = 0; k < backend->way; k++) {
+                uint64_t *state = &expected[k * 25];
+                reference->keccakf(&state);
+            }
+        }
+        BOOST_CHECK(states == expected);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
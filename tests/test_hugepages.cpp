@@ -0,0 +1,60 @@
+#include <fingera/hugepages.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <utility>
+
+BOOST_AUTO_TEST_SUITE(hugepages_tests)
+
+BOOST_AUTO_TEST_CASE(buffer) {
+    using namespace fingera;
+
+    hugepage_buffer empty;
+    BOOST_CHECK(empty.data() == nullptr);
+    BOOST_CHECK_EQUAL(empty.size(), 0);
+    BOOST_CHECK_EQUAL(empty.kind(), hugepage_buffer::none);
+
+    hugepage_counters before = get_hugepage_counters();
+    // not a multiple of the page size
+    hugepage_buffer a(3 << 20);
+    BOOST_REQUIRE(a.data() != nullptr);
+    BOOST_CHECK_EQUAL(a.size(), 3 << 20);
+    BOOST_CHECK_EQUAL((uintptr_t)a.data() % (1 << 21), 0);
+    BOOST_CHECK_NE(a.kind(), hugepage_buffer::none);
+    BOOST_TEST_MESSAGE("hugepage_buffer kind " << a.kind());
+    memset(a.data(), 0x5a, a.size());
+    BOOST_CHECK_EQUAL(a.data()[a.size() - 1], 0x5a);
+
+    hugepage_counters after = get_hugepage_counters();
+    BOOST_CHECK_EQUAL(after.hugetlb - before.hugetlb, a.kind() == hugepage_buffer::hugetlb ? 1 : 0);
+    BOOST_CHECK_EQUAL(after.transparent - before.transparent, a.kind() == hugepage_buffer::transparent ? 1 : 0);
+    BOOST_CHECK_EQUAL(after.normal - before.normal, a.kind() == hugepage_buffer::normal ? 1 : 0);
+
+    uint8_t *data = a.data();
+    hugepage_buffer b(std::move(a));
+    BOOST_CHECK(a.data() == nullptr);
+    BOOST_CHECK_EQUAL(a.kind(), hugepage_buffer::none);
+    BOOST_CHECK(b.data() == data);
+    b = hugepage_buffer(1 << 21);
+    BOOST_CHECK_EQUAL(b.size(), 1 << 21);
+    b = std::move(empty);
+    BOOST_CHECK(b.data() == nullptr);
+    BOOST_CHECK_EQUAL(b.resident_node(), -1);
+}
+
+// the node a buffer prefers, when the kernel reports one, is where it lands
+BOOST_AUTO_TEST_CASE(numa_node) {
+    using namespace fingera;
+
+    hugepage_buffer a(1 << 21);
+    memset(a.data(), 1, a.size());
+    const int node = a.resident_node();
+    BOOST_TEST_MESSAGE("resident_node " << node);
+    if (node < 0) return;
+
+    hugepage_buffer b(1 << 21, node);
+    memset(b.data(), 1, b.size());
+    BOOST_CHECK_EQUAL(b.resident_node(), node);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,134 @@
+#include <fingera/miner.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fingera/endian.hpp>
+#include <fingera/hash/monero.hpp>
+#include <fingera/hex.hpp>
+
+BOOST_AUTO_TEST_SUITE(miner_tests)
+
+// every nonce of a small range is a share, found once by some worker
+BOOST_AUTO_TEST_CASE(shares) {
+    using namespace fingera;
+
+    std::mutex mutex;
+    std::condition_variable found;
+    std::vector<miner_share> shares;
+    miner_options options;
+    options.threads = 2;
+    options.ways = 2;
+    options.batch = 3;
+    miner m([&](const miner_share &share) {
+        std::lock_guard<std::mutex> lock(mutex);
+        shares.push_back(share);
+        found.notify_all();
+    }, options);
+    BOOST_CHECK_EQUAL(m.threads(), 2);
+
+    miner_job job;
+    job.id = "1";
+    job.algorithm = "cn-lite/1";
+    BOOST_CHECK(from_hex("0707c3d4a9db055ced477105ab5607d19fa12cf3f538f0e4e724f3bde40ddc05d16a9a068001885b038000b9ba16ee6a563456fc9ec93af68675a295f592992645a54175b375e66e32429e01", job.blob));
+    job.target64 = UINT64_MAX;
+    job.nonce_begin = 100;
+    job.nonce_end = 110;
+    m.set_job(job);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        BOOST_REQUIRE(found.wait_for(lock, std::chrono::seconds(60), [&] { return shares.size() == 10; }));
+    }
+
+    std::set<uint32_t> nonces;
+    for (const miner_share &share : shares) {
+        BOOST_CHECK_EQUAL(share.job_id, "1");
+        std::vector<uint8_t> blob = job.blob;
+        write_little<uint32_t>(&blob[39], share.nonce);
+        uint8_t expected[32];
+        hash::cryptonight("cn-lite/1", &blob[0], blob.size(), expected);
+        BOOST_CHECK_EQUAL(to_hex(share.result, 32), to_hex(expected, 32));
+        nonces.insert(share.nonce);
+    }
+    BOOST_CHECK_EQUAL(nonces.size(), 10);
+    BOOST_CHECK_EQUAL(*nonces.begin(), 100);
+    BOOST_CHECK_EQUAL(*nonces.rbegin(), 109);
+
+    // range done: idle until the next job, the counters follow the last share
+    std::vector<miner_worker_stats> stats;
+    for (int i = 0; i < 1000; i++) {
+        stats = m.stats();
+        if (stats[0].hashes + stats[1].hashes == 10) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    BOOST_REQUIRE_EQUAL(stats.size(), 2);
+    BOOST_CHECK_EQUAL(stats[0].hashes + stats[1].hashes, 10);
+    size_t workers = 0;
+    for (const miner_node_stats &node : m.node_stats()) {
+        BOOST_TEST_MESSAGE("node " << node.node << " workers " << node.workers << " misplaced " << node.misplaced);
+        BOOST_CHECK_EQUAL(node.misplaced, 0);
+        workers += node.workers;
+    }
+    BOOST_CHECK_EQUAL(workers, 2);
+
+    job.id = "2";
+    job.nonce_end = 101;
+    m.set_job(job);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        BOOST_REQUIRE(found.wait_for(lock, std::chrono::seconds(60), [&] { return shares.size() == 11; }));
+        BOOST_CHECK_EQUAL(shares.back().job_id, "2");
+        BOOST_CHECK_EQUAL(shares.back().nonce, 100);
+    }
+
+    job.algorithm = "cn/unknown";
+    BOOST_CHECK_THROW(m.set_job(job), std::invalid_argument);
+    job.algorithm = "cn-lite/1";
+    job.nonce_end = job.nonce_begin;
+    BOOST_CHECK_THROW(m.set_job(job), std::invalid_argument);
+    m.stop();
+}
+
+BOOST_AUTO_TEST_CASE(default_threads) {
+    using namespace fingera;
+
+    size_t n = miner::default_threads("cn/1");
+    BOOST_TEST_MESSAGE("default_threads " << n);
+    BOOST_CHECK_GE(n, 1);
+    BOOST_CHECK_LE(n, std::max(1u, std::thread::hardware_concurrency()));
+    BOOST_CHECK_GE(miner::default_threads("cn-lite/1"), n);
+    BOOST_CHECK_LE(miner::default_threads("cn/1", 2), n);
+}
+
+// without a thread count every job gets its algorithm's default_threads
+BOOST_AUTO_TEST_CASE(job_threads) {
+    using namespace fingera;
+
+    miner_options options;
+    options.ways = 2;
+    miner m([](const miner_share &) {}, options);
+    BOOST_CHECK_EQUAL(m.active_threads(), 0);
+    BOOST_CHECK_GE(m.threads(), miner::default_threads("cn-lite/1", 2));
+
+    miner_job job;
+    job.algorithm = "cn-lite/1";
+    BOOST_CHECK(from_hex("0707c3d4a9db055ced477105ab5607d19fa12cf3f538f0e4e724f3bde40ddc05d16a9a068001885b038000b9ba16ee6a563456fc9ec93af68675a295f592992645a54175b375e66e32429e01", job.blob));
+    job.nonce_end = 1;
+    m.set_job(job);
+    BOOST_CHECK_EQUAL(m.active_threads(), miner::default_threads("cn-lite/1", 2));
+    job.algorithm = "cn/1";
+    m.set_job(job);
+    BOOST_CHECK_EQUAL(m.active_threads(), miner::default_threads("cn/1", 2));
+    m.pause();
+    BOOST_CHECK_EQUAL(m.active_threads(), 0);
+    m.stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()